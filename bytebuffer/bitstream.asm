@@ -0,0 +1,459 @@
+;-------------------------------------------------------------------------------
+;   ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+;
+;   Copyright (C) 2025  J. McIntosh
+;
+;   This program is free software; you can redistribute it and/or modify
+;   it under the terms of the GNU General Public License as published by
+;   the Free Software Foundation; either version 2 of the License, or
+;   (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License along
+;   with this program; if not, write to the Free Software Foundation, Inc.,
+;   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;-------------------------------------------------------------------------------
+%ifndef BITSTREAM_ASM
+%define BITSTREAM_ASM  1
+;
+; Bits are packed LSB first into a 64-bit accumulator (bb->bit_acc) that is
+; written to / read from the buffer one whole (little endian) word at a time.
+;
+; Writer: bb->bit_count bits are pending in bb->bit_acc and have not been
+;         written yet.  bb_put_bits_align writes them out (rounded up to a
+;         byte) so byte oriented puts may follow.
+;
+; Reader: bb->bit_count bits have been loaded into bb->bit_acc but not yet
+;         returned.  bb->index is already past the bytes they came from;
+;         bb_get_bits_align gives back the whole unread bytes.
+;
+%include "bytebuffer.inc"
+;
+section .text
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put the low nbits of value in bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bits (bytebuffer_t *bb, uint64_t value, uint32_t nbits);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = value
+;   rdx = nbits (1 - 64)
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bits:function
+bb_put_bits:
+; if (nbits == 0 || nbits > 64) return;
+      mov       edx, edx
+      test      rdx, rdx
+      jz        .return
+      cmp       rdx, 64
+      ja        .return
+; value &= mask(nbits);
+      bzhi      rsi, rsi, rdx
+; acc = bb->bit_acc | (value << bb->bit_count);
+      mov       rcx, QWORD [rdi + bytebuffer.bit_count]
+      shlx      rax, rsi, rcx
+      or        rax, QWORD [rdi + bytebuffer.bit_acc]
+; total = bb->bit_count + nbits;
+      add       rdx, rcx
+; if (total >= 64) goto flush;
+      cmp       rdx, 64
+      jae       .flush
+; bb->bit_acc = acc; bb->bit_count = total;
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rdx
+      ret
+.flush:
+; if (bb->index + 8 > bb->bound) return;
+      mov       r8, QWORD [rdi + bytebuffer.index]
+      lea       r9, [r8 + 8]
+      cmp       r9, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; *(uint64_t *) &bb->buffer[bb->index] = acc;
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      mov       QWORD [r10 + r8], rax
+; bb->index += 8;
+      mov       QWORD [rdi + bytebuffer.index], r9
+; bb->bit_acc = bb->bit_count ? value >> (64 - bb->bit_count) : 0;
+      xor       rax, rax
+      test      rcx, rcx
+      jz        .store
+      neg       rcx
+      shrx      rax, rsi, rcx
+.store:
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+; bb->bit_count = total - 64;
+      sub       rdx, 64
+      mov       QWORD [rdi + bytebuffer.bit_count], rdx
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Write pending bits to bytebuffer padding to a byte boundary
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bits_align (bytebuffer_t *bb);
+;
+; param:
+;
+;   rdi = bb
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bits_align:function
+bb_put_bits_align:
+; if (bb->bit_count == 0) return;
+      mov       rcx, QWORD [rdi + bytebuffer.bit_count]
+      test      rcx, rcx
+      jz        .return
+; n = (bb->bit_count + 7) / 8;
+      add       rcx, 7
+      shr       rcx, 3
+; if (bb->index + n > bb->bound) return;
+      mov       r8, QWORD [rdi + bytebuffer.index]
+      lea       r9, [r8 + rcx]
+      cmp       r9, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; byte_t *bp = &bb->buffer[bb->index];
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, r8
+; for (acc = bb->bit_acc; n > 0; --n, acc >>= 8) *bp++ = (byte_t) acc;
+      mov       rax, QWORD [rdi + bytebuffer.bit_acc]
+.put_byte:
+      mov       BYTE [r10], al
+      inc       r10
+      shr       rax, 8
+      dec       rcx
+      jnz       .put_byte
+; bb->index += n;
+      mov       QWORD [rdi + bytebuffer.index], r9
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an array of uint32_t values in bytebuffer using nbits for each value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bits_array (bytebuffer_t *bb, uint32_t const *src,
+;                           size_t count, uint32_t nbits);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = src
+;   rdx = count
+;   rcx = nbits (1 - 32)
+;
+; NOTE: Nothing is written if the words that would be flushed do not fit
+;       before the bound.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bits_array:function
+bb_put_bits_array:
+      push      rbx
+; if (count == 0 || nbits == 0 || nbits > 32) return;
+      mov       ecx, ecx
+      test      rdx, rdx
+      jz        .return
+      test      rcx, rcx
+      jz        .return
+      cmp       rcx, 32
+      ja        .return
+; if (((bb->bit_count + count * nbits) / 64) * 8 > bb->bound - bb->index) return;
+      mov       rax, rdx
+      imul      rax, rcx
+      add       rax, QWORD [rdi + bytebuffer.bit_count]
+      shr       rax, 6
+      shl       rax, 3
+      mov       r11, QWORD [rdi + bytebuffer.bound]
+      sub       r11, QWORD [rdi + bytebuffer.index]
+      jb        .return
+      cmp       rax, r11
+      ja        .return
+; r8 = acc, r9 = bit count, r10 = write pointer
+      mov       r8, QWORD [rdi + bytebuffer.bit_acc]
+      mov       r9, QWORD [rdi + bytebuffer.bit_count]
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, QWORD [rdi + bytebuffer.index]
+.next_value:
+; value = *src++ & mask(nbits);
+      mov       eax, DWORD [rsi]
+      add       rsi, 4
+      bzhi      rax, rax, rcx
+; acc |= value << bits; bits += nbits;
+      shlx      rbx, rax, r9
+      or        r8, rbx
+      add       r9, rcx
+; if (bits < 64) continue;
+      cmp       r9, 64
+      jb        .continue
+; *(uint64_t *) wp = acc; wp += 8; bits -= 64;
+      mov       QWORD [r10], r8
+      add       r10, 8
+      sub       r9, 64
+; acc = value >> (nbits - bits);    (0 when the value fit exactly)
+      mov       rbx, rcx
+      sub       rbx, r9
+      shrx      r8, rax, rbx
+.continue:
+      dec       rdx
+      jnz       .next_value
+; bb->bit_acc = acc; bb->bit_count = bits;
+      mov       QWORD [rdi + bytebuffer.bit_acc], r8
+      mov       QWORD [rdi + bytebuffer.bit_count], r9
+; bb->index = wp - bb->buffer;
+      sub       r10, QWORD [rdi + bytebuffer.buffer]
+      mov       QWORD [rdi + bytebuffer.index], r10
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get the next nbits from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   uint64_t bb_get_bits (bytebuffer_t *bb, uint32_t nbits);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = nbits (1 - 64)
+;
+; return:
+;
+;   rax = value | 0 (not enough bits before bound)
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bits:function
+bb_get_bits:
+      push      rbx
+; if (nbits == 0 || nbits > 64) return 0;
+      xor       rax, rax
+      mov       esi, esi
+      test      rsi, rsi
+      jz        .return
+      cmp       rsi, 64
+      ja        .return
+; if (bb->bit_count < nbits) goto refill;
+      mov       rcx, QWORD [rdi + bytebuffer.bit_count]
+      mov       rax, QWORD [rdi + bytebuffer.bit_acc]
+      cmp       rcx, rsi
+      jb        .refill
+; bb->bit_acc = acc >> nbits; bb->bit_count -= nbits;
+      shrx      rdx, rax, rsi
+      mov       QWORD [rdi + bytebuffer.bit_acc], rdx
+      sub       rcx, rsi
+      mov       QWORD [rdi + bytebuffer.bit_count], rcx
+; return acc & mask(nbits);
+      bzhi      rax, rax, rsi
+      pop       rbx
+      ret
+.refill:
+; n = min(bb->bound - bb->index, 8); if (n == 0) return 0;
+      mov       r8, QWORD [rdi + bytebuffer.index]
+      mov       r9, QWORD [rdi + bytebuffer.bound]
+      sub       r9, r8
+      jbe       .empty
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, r8
+      cmp       r9, 8
+      jb        .partial
+; word = *(uint64_t *) &bb->buffer[bb->index];
+      mov       rdx, QWORD [r10]
+      mov       r9, 8
+      jmp       .have_word
+.partial:
+; for (word = 0, i = n; i > 0; --i) word = (word << 8) | bp[i - 1];
+      xor       rdx, rdx
+      mov       r11, r9
+.get_byte:
+      shl       rdx, 8
+      movzx     ebx, BYTE [r10 + r11 - 1]
+      or        rdx, rbx
+      dec       r11
+      jnz       .get_byte
+.have_word:
+; total = bb->bit_count + n * 8; if (total < nbits) return 0;
+      lea       r11, [rcx + r9 * 8]
+      cmp       r11, rsi
+      jb        .empty
+; bb->index += n;
+      add       r8, r9
+      mov       QWORD [rdi + bytebuffer.index], r8
+; value = (acc | (word << bb->bit_count)) & mask(nbits);
+      shlx      rbx, rdx, rcx
+      or        rax, rbx
+      bzhi      rax, rax, rsi
+; used = nbits - bb->bit_count;
+      mov       rbx, rsi
+      sub       rbx, rcx
+; bb->bit_acc = (used < 64) ? word >> used : 0;
+      shrx      rdx, rdx, rbx
+      cmp       rbx, 64
+      jb        .store
+      xor       rdx, rdx
+.store:
+      mov       QWORD [rdi + bytebuffer.bit_acc], rdx
+; bb->bit_count = total - nbits;
+      sub       r11, rsi
+      mov       QWORD [rdi + bytebuffer.bit_count], r11
+      pop       rbx
+      ret
+.empty:
+      xor       rax, rax
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Drop bits up to the next byte boundary and return unread bytes to bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_bits_align (bytebuffer_t *bb);
+;
+; param:
+;
+;   rdi = bb
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bits_align:function
+bb_get_bits_align:
+; bb->index -= bb->bit_count / 8;
+      mov       rcx, QWORD [rdi + bytebuffer.bit_count]
+      shr       rcx, 3
+      mov       rax, QWORD [rdi + bytebuffer.index]
+      sub       rax, rcx
+      mov       QWORD [rdi + bytebuffer.index], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an array of uint32_t values of nbits each from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_bits_array (bytebuffer_t *bb, uint32_t *dst,
+;                           size_t count, uint32_t nbits);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = dst
+;   rdx = count
+;   rcx = nbits (1 - 32)
+;
+; NOTE: Nothing is read if fewer than count * nbits bits remain.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bits_array:function
+bb_get_bits_array:
+      push      rbx
+      push      r12
+; if (count == 0 || nbits == 0 || nbits > 32) return;
+      mov       ecx, ecx
+      test      rdx, rdx
+      jz        .return
+      test      rcx, rcx
+      jz        .return
+      cmp       rcx, 32
+      ja        .return
+; if (count * nbits > bb->bit_count + (bb->bound - bb->index) * 8) return;
+      mov       r11, QWORD [rdi + bytebuffer.bound]
+      sub       r11, QWORD [rdi + bytebuffer.index]
+      jb        .return
+      shl       r11, 3
+      add       r11, QWORD [rdi + bytebuffer.bit_count]
+      mov       rax, rdx
+      imul      rax, rcx
+      cmp       rax, r11
+      ja        .return
+; r8 = acc, r9 = bit count, r10 = read pointer, r11 = end of data
+      mov       r8, QWORD [rdi + bytebuffer.bit_acc]
+      mov       r9, QWORD [rdi + bytebuffer.bit_count]
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      mov       r11, r10
+      add       r10, QWORD [rdi + bytebuffer.index]
+      add       r11, QWORD [rdi + bytebuffer.bound]
+.next_value:
+; if (bits >= nbits) goto take;
+      cmp       r9, rcx
+      jae       .take
+; n = min(end - rp, 8);
+      mov       rbx, r11
+      sub       rbx, r10
+      cmp       rbx, 8
+      jb        .partial
+; word = *(uint64_t *) rp; rp += 8;
+      mov       r12, QWORD [r10]
+      add       r10, 8
+      mov       rbx, 64
+      jmp       .have_word
+.partial:
+; for (word = 0, i = n; i > 0; --i) word = (word << 8) | rp[i - 1]; rp += n;
+      push      rdx
+      xor       r12, r12
+      mov       rdx, rbx
+.get_byte:
+      shl       r12, 8
+      movzx     eax, BYTE [r10 + rdx - 1]
+      or        r12, rax
+      dec       rdx
+      jnz       .get_byte
+      pop       rdx
+      add       r10, rbx
+      shl       rbx, 3
+.have_word:
+; value = (acc | (word << bits)) & mask(nbits);
+      shlx      rax, r12, r9
+      or        rax, r8
+      bzhi      rax, rax, rcx
+; acc = word >> (nbits - bits);
+      mov       r8, rcx
+      sub       r8, r9
+      shrx      r8, r12, r8
+; bits += n * 8 - nbits;
+      add       r9, rbx
+      sub       r9, rcx
+      jmp       .store
+.take:
+; value = acc & mask(nbits); acc >>= nbits; bits -= nbits;
+      mov       rax, r8
+      bzhi      rax, rax, rcx
+      shrx      r8, r8, rcx
+      sub       r9, rcx
+.store:
+; *dst++ = (uint32_t) value;
+      mov       DWORD [rsi], eax
+      add       rsi, 4
+      dec       rdx
+      jnz       .next_value
+; bb->bit_acc = acc; bb->bit_count = bits;
+      mov       QWORD [rdi + bytebuffer.bit_acc], r8
+      mov       QWORD [rdi + bytebuffer.bit_count], r9
+; bb->index = rp - bb->buffer;
+      sub       r10, QWORD [rdi + bytebuffer.buffer]
+      mov       QWORD [rdi + bytebuffer.index], r10
+.return:
+      pop       r12
+      pop       rbx
+      ret
+%endif
@@ -20,32 +20,27 @@
 %ifndef BYTEBUFFER_ASM
 %define BYTEBUFFER_ASM  1
 ;
+extern __errno_location
 extern calloc
 extern free
 extern memset
+extern mmap
+extern munmap
+extern madvise
+extern posix_memalign
 extern strlen
 extern memmove64
 ;
-ALIGN_SIZE    EQU     16
-ALIGN_WITH    EQU     (ALIGN_SIZE - 1)
-ALIGN_MASK    EQU     ~(ALIGN_WITH)
-;
-;-------------------------------------------------------------------------------
-;
-%macro ALIGN_STACK_AND_CALL 2-4
-      mov     %1, rsp               ; backup stack pointer (rsp)
-      and     rsp, QWORD ALIGN_MASK ; align stack pointer (rsp) to
-                                    ; 16-byte boundary
-      call    %2 %3 %4              ; call C function
-      mov     rsp, %1               ; restore stack pointer (rsp)
-%endmacro
-;
-; Example: Call LIBC function
-;         ALIGN_STACK_AND_CALL r15, calloc, wrt, ..plt
-;
-; Example: Call C callback function with address in register (rcx)
-;         ALIGH_STACK_AND_CALL r12, rcx
-;-------------------------------------------------------------------------------
+PROT_READ     EQU     0x01
+PROT_WRITE    EQU     0x02
+MAP_PRIVATE   EQU     0x02
+MAP_ANONYMOUS EQU     0x20
+MAP_HUGETLB   EQU     0x40000
+MAP_FAILED    EQU     -1
+MADV_HUGEPAGE EQU     14
+MPOL_PREFERRED  EQU   1
+EINVAL        EQU     22
+SYS_MBIND     EQU     237
 ;
 %include "bytebuffer.inc"
 ;
@@ -78,53 +73,312 @@ bb_native_byte_order:
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 ; C definition
 ;
-;   int bb_init (bytebuffer_t *bb, size_t size);
+;   int bb_init (bytebuffer_t *bb, size_t size, bb_commit_cb cb);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = size
+;   rdx = cb (unused)
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_init:function
+bb_init:
+; return bb_init_ex(bb, size, BB_ALLOC_DEFAULT, -1);
+      mov       rdx, BB_ALLOC_DEFAULT
+      mov       rcx, -1
+      jmp       bb_init_ex wrt ..plt
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Initialize bytebuffer with allocation flags
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   int bb_init_ex (bytebuffer_t *bb, size_t size, uint32_t flags, int node);
 ;
 ; param:
 ;
 ;   rdi = bb
 ;   rsi = size
+;   rdx = flags
+;   rcx = node (only used with BB_ALLOC_NUMA_NODE)
 ;
 ; stack:
 ;
-;   QWORD [rbp - 8] = rdi (bb);
+;   QWORD [rbp - 8]   = rdi (bb)
+;   QWORD [rbp - 16]  = rdx (flags)
+;   QWORD [rbp - 24]  = rcx (node)
+;   QWORD [rbp - 32]  = len (length of mapping)
+;   QWORD [rbp - 40]  = nodemask | err (errno to set on failure)
+;
+; return:
+;
+;   eax = 1 (success) | -1 (failure, errno set)
+;
+; NOTE: With a mapping flag a size of 0 still maps one page, so that every
+;       flag combination accepts the sizes the calloc path accepts.
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 ;
-      global bb_init:function
-bb_init:
+      global bb_init_ex:function
+bb_init_ex:
       push      rbp
       mov       rbp, rsp
-      sub       rsp, 8
+      sub       rsp, 40
       push      rbx
 ; QWORD [rbp - 8] = rdi (bb);
       mov       QWORD [rbp - 8], rdi
+; QWORD [rbp - 16] = rdx (flags);
+      mov       edx, edx
+      mov       QWORD [rbp - 16], rdx
+; QWORD [rbp - 24] = rcx (node);
+      movsxd    rcx, ecx
+      mov       QWORD [rbp - 24], rcx
 ; bb->bound = size;
       mov       QWORD [rdi + bytebuffer.bound], rsi
 ; bb->index = 0;
       xor       rax, rax
       mov       QWORD [rdi + bytebuffer.index], rax
+; bb->buffer = NULL;
+      mov       QWORD [rdi + bytebuffer.buffer], rax
+; bb->map_size = 0;
+      mov       QWORD [rdi + bytebuffer.map_size], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
 ; bb->mark = -1;
       mov       rax, -1
       mov       QWORD [rdi + bytebuffer.mark], rax
 ; bb->size = size;
       mov       QWORD [rdi + bytebuffer.size], rsi
+; if (flags & BB_ALLOC_MMAP_MASK) goto map_buffer;
+      test      rdx, BB_ALLOC_MMAP_MASK
+      jnz       .map_buffer
+; if (flags & BB_ALLOC_ALIGN_64) goto align_buffer;
+      test      rdx, BB_ALLOC_ALIGN_64
+      jnz       .align_buffer
 ; bb->buffer = calloc(1, size);
+      mov       rdi, 1
       ALIGN_STACK_AND_CALL rbx, calloc, wrt, ..plt
       mov       rdi, QWORD [rbp - 8]
       mov       QWORD [rdi + bytebuffer.buffer], rax
-; return (bb->buffer ? 1 : -1);
-      mov       ebx, 1
       test      rax, rax
-      jnz       .success
-      neg       ebx
+      jz        .failure
+      jmp       .success
+.align_buffer:
+; if ((err = posix_memalign(&bb->buffer, CACHE_LINE_SIZE, size)) != 0)
+;   goto set_errno;
+; posix_memalign returns the error instead of setting errno
+      mov       rdx, rsi
+      mov       rsi, CACHE_LINE_SIZE
+      lea       rdi, [rdi + bytebuffer.buffer]
+      ALIGN_STACK_AND_CALL rbx, posix_memalign, wrt, ..plt
+      mov       QWORD [rbp - 40], rax
+      test      eax, eax
+      jnz       .set_errno
+; (void) memset(bb->buffer, 0, size);
+      mov       rax, QWORD [rbp - 8]
+      mov       rdi, QWORD [rax + bytebuffer.buffer]
+      xor       rsi, rsi
+      mov       rdx, QWORD [rax + bytebuffer.size]
+      ALIGN_STACK_AND_CALL rbx, memset, wrt, ..plt
+      jmp       .success
+.map_buffer:
+; len = (size + PAGE_SIZE - 1) & PAGE_MASK;
+      lea       rax, [rsi + PAGE_SIZE - 1]
+      and       rax, PAGE_MASK
+; if (len == 0) len = PAGE_SIZE;
+      mov       rcx, PAGE_SIZE
+      test      rax, rax
+      cmovz     rax, rcx
+      mov       QWORD [rbp - 32], rax
+; if (!(flags & BB_ALLOC_HUGEPAGE) || size < HUGE_PAGE_SIZE) goto map_pages;
+      test      rdx, BB_ALLOC_HUGEPAGE
+      jz        .map_pages
+      cmp       rsi, HUGE_PAGE_SIZE
+      jb        .map_pages
+; len = (size + HUGE_PAGE_SIZE - 1) & HUGE_PAGE_MASK;
+      lea       rax, [rsi + HUGE_PAGE_SIZE - 1]
+      and       rax, HUGE_PAGE_MASK
+      mov       QWORD [rbp - 32], rax
+; p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+;          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      xor       rdi, rdi
+      mov       rsi, rax
+      mov       rdx, PROT_READ | PROT_WRITE
+      mov       rcx, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+      mov       r8, -1
+      xor       r9, r9
+      ALIGN_STACK_AND_CALL rbx, mmap, wrt, ..plt
+; if (p != MAP_FAILED) goto have_map;
+      cmp       rax, MAP_FAILED
+      jne       .have_map
+; no hugetlbfs pages reserved, fall back to transparent huge pages
+; p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      xor       rdi, rdi
+      mov       rsi, QWORD [rbp - 32]
+      mov       rdx, PROT_READ | PROT_WRITE
+      mov       rcx, MAP_PRIVATE | MAP_ANONYMOUS
+      mov       r8, -1
+      xor       r9, r9
+      ALIGN_STACK_AND_CALL rbx, mmap, wrt, ..plt
+      cmp       rax, MAP_FAILED
+      je        .failure
+      mov       rdi, QWORD [rbp - 8]
+      mov       QWORD [rdi + bytebuffer.buffer], rax
+; (void) madvise(p, len, MADV_HUGEPAGE);
+      mov       rdi, rax
+      mov       rsi, QWORD [rbp - 32]
+      mov       rdx, MADV_HUGEPAGE
+      ALIGN_STACK_AND_CALL rbx, madvise, wrt, ..plt
+      mov       rdi, QWORD [rbp - 8]
+      mov       rax, QWORD [rdi + bytebuffer.buffer]
+      jmp       .have_map
+.map_pages:
+; p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      xor       rdi, rdi
+      mov       rsi, QWORD [rbp - 32]
+      mov       rdx, PROT_READ | PROT_WRITE
+      mov       rcx, MAP_PRIVATE | MAP_ANONYMOUS
+      mov       r8, -1
+      xor       r9, r9
+      ALIGN_STACK_AND_CALL rbx, mmap, wrt, ..plt
+      cmp       rax, MAP_FAILED
+      je        .failure
+.have_map:
+; bb->buffer = p;
+      mov       rdi, QWORD [rbp - 8]
+      mov       QWORD [rdi + bytebuffer.buffer], rax
+; bb->map_size = len;
+      mov       rcx, QWORD [rbp - 32]
+      mov       QWORD [rdi + bytebuffer.map_size], rcx
+; if (!(flags & BB_ALLOC_NUMA_NODE)) goto prefault;
+      mov       rdx, QWORD [rbp - 16]
+      test      rdx, BB_ALLOC_NUMA_NODE
+      jz        .prefault
+; if (node < 0 || node >= 64) { err = EINVAL; goto unmap; }
+      mov       rcx, QWORD [rbp - 24]
+      mov       QWORD [rbp - 40], EINVAL
+      cmp       rcx, 64
+      jae       .unmap
+; nodemask = 1 << node;
+      mov       rdx, 1
+      shlx      rdx, rdx, rcx
+      mov       QWORD [rbp - 40], rdx
+; r = syscall(SYS_mbind, p, len, MPOL_PREFERRED, &nodemask, 65, 0);
+; pages are not faulted in yet so the policy applies to every page
+      mov       rdi, rax
+      mov       rsi, QWORD [rbp - 32]
+      mov       rdx, MPOL_PREFERRED
+      lea       r10, [rbp - 40]
+      mov       r8, 65
+      xor       r9, r9
+      mov       rax, SYS_MBIND
+      syscall
+; placement is a hint: keep the unbound mapping if mbind is not available
+; (ENOSYS, EPERM under seccomp, ...); only a node the kernel does not know
+; fails the allocation
+; if (r == -EINVAL) { err = EINVAL; goto unmap; }
+      cmp       rax, -EINVAL
+      jne       .prefault
+      neg       rax
+      mov       QWORD [rbp - 40], rax
+      jmp       .unmap
+.prefault:
+; if (flags & BB_ALLOC_PREFAULT)
+;   for (off = 0; off < len; off += PAGE_SIZE) p[off] = 0;
+      mov       rdx, QWORD [rbp - 16]
+      test      rdx, BB_ALLOC_PREFAULT
+      jz        .success
+      mov       rdi, QWORD [rbp - 8]
+      mov       rsi, QWORD [rdi + bytebuffer.buffer]
+      mov       rcx, QWORD [rbp - 32]
+      xor       rax, rax
+.touch_page:
+      mov       BYTE [rsi + rax], 0
+      add       rax, PAGE_SIZE
+      cmp       rax, rcx
+      jb        .touch_page
+      jmp       .success
+.unmap:
+; (void) munmap(p, len);
+      mov       rdi, QWORD [rbp - 8]
+      mov       rdi, QWORD [rdi + bytebuffer.buffer]
+      mov       rsi, QWORD [rbp - 32]
+      ALIGN_STACK_AND_CALL rbx, munmap, wrt, ..plt
+; bb->buffer = NULL; bb->map_size = 0;
+      mov       rdi, QWORD [rbp - 8]
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.buffer], rax
+      mov       QWORD [rdi + bytebuffer.map_size], rax
+.set_errno:
+; errno = err;
+      ALIGN_STACK_AND_CALL rbx, __errno_location, wrt, ..plt
+      mov       rcx, QWORD [rbp - 40]
+      mov       DWORD [rax], ecx
+.failure:
+; return -1;
+      mov       eax, -1
+      jmp       .epilogue
 .success:
-      mov       eax, ebx
+; return 1;
+      mov       eax, 1
+.epilogue:
       pop       rbx
       mov       rsp, rbp
       pop       rbp
       ret
 ;
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Initialize small buffer optimized bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   int bb_sbo_init (bytebuffer_sbo_t *sbo, size_t size, bb_commit_cb cb);
+;
+; param:
+;
+;   rdi = sbo
+;   rsi = size
+;   rdx = cb
+;
+; return:
+;
+;   eax = 1 (success) | -1 (failure)
+;
+; NOTE: A size up to BB_SBO_CAPACITY uses the storage that follows the
+;       header, so no allocation is made and the data is one line away
+;       from index and bound.  A larger size is handed to bb_init.  Either
+;       way &sbo->bb works with every bb_* function, including bb_term.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_sbo_init:function
+bb_sbo_init:
+; if (size > BB_SBO_CAPACITY) return bb_init(&sbo->bb, size, cb);
+      cmp       rsi, BB_SBO_CAPACITY
+      jbe       .inline
+      jmp       bb_init wrt ..plt
+.inline:
+; (void) memset(sbo, 0, sizeof(bytebuffer_sbo_t));
+      pxor      xmm0, xmm0
+      mov       rcx, bytebuffer_sbo_size
+.zero:
+      sub       rcx, 16
+      movdqu    [rdi + rcx], xmm0
+      jnz       .zero
+; sbo->bb.bound = size; sbo->bb.size = size; sbo->bb.mark = -1;
+      mov       QWORD [rdi + bytebuffer.bound], rsi
+      mov       QWORD [rdi + bytebuffer.size], rsi
+      mov       QWORD [rdi + bytebuffer.mark], -1
+; sbo->bb.buffer = sbo->storage;
+      lea       rax, [rdi + bytebuffer_sbo.storage]
+      mov       QWORD [rdi + bytebuffer.buffer], rax
+; sbo->bb.map_size = BB_MAP_INLINE;
+      mov       QWORD [rdi + bytebuffer.map_size], BB_MAP_INLINE
+; return 1;
+      mov       eax, 1
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 ; Terminate bytebuffer
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 ; C definition
@@ -148,9 +402,22 @@ bb_term:
       push      rbx
 ; QWORD [rbp - 8] = rdi (bb)
       mov       QWORD [rbp - 8], rdi
+; if (bb->map_size == BB_MAP_INLINE) goto clear;  (BB_MAP_VIEW is the same)
+      mov       rsi, QWORD [rdi + bytebuffer.map_size]
+      cmp       rsi, BB_MAP_INLINE
+      je        .clear
+; if (bb->map_size != 0) goto unmap;
+      test      rsi, rsi
+      jnz       .unmap
 ; free(bb->buffer);
       mov       rdi, QWORD [rdi + bytebuffer.buffer]
       ALIGN_STACK_AND_CALL rbx, free, wrt, ..plt
+      jmp       .clear
+.unmap:
+; (void) munmap(bb->buffer, bb->map_size);
+      mov       rdi, QWORD [rdi + bytebuffer.buffer]
+      ALIGN_STACK_AND_CALL rbx, munmap, wrt, ..plt
+.clear:
 ; (void) memset(bb, 0, sizeof(bytebuffer_t));
       mov       rdi, QWORD [rbp - 8]
       xor       rsi, rsi
@@ -317,6 +584,10 @@ bb_clear:
 ; bb->mark = -1;
       mov       rax, -1
       mov       QWORD [rdi + bytebuffer.mark], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
       ret
 ;
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -382,6 +653,10 @@ bb_rewind:
 ; bb->mark = -1;
       mov       rax, -1
       mov       QWORD [rdi + bytebuffer.mark], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
       ret
 ;
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -402,6 +677,10 @@ bb_set_index:
 ; bb->index = index;
       mov       rax, rsi
       mov       QWORD [rdi + bytebuffer.index], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
       ret
 ;
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -424,6 +703,10 @@ bb_flip:
 ; bb->index = 0;
       xor       rax, rax
       mov       QWORD [rdi + bytebuffer.index], rax
+; bb->bit_acc = 0; bb->bit_count = 0;
+      xor       rax, rax
+      mov       QWORD [rdi + bytebuffer.bit_acc], rax
+      mov       QWORD [rdi + bytebuffer.bit_count], rax
       ret
 ;
 ;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -17,6 +17,12 @@
     with this program; if not, write to the Free Software Foundation, Inc.,
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 ------------------------------------------------------------------------------*/
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
 #include "bytebuffer.h"
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // initByteBufferLibaray
@@ -25,3 +31,607 @@ void __attribute__ ((constructor)) initByteBufferLibrary (void) { }
 // termByteBufferLibaray
 void __attribute__ ((destructor)) termByteBufferLibrary (void) { }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// parallel record decode
+//
+// Workers take BB_DECODE_BATCH records at a time from a shared counter, so a
+// slow stretch of records does not hold up the others.  Each worker reads
+// through its own view (see bb_record_at); the storage itself is shared and
+// must not be written until bb_decode_parallel returns.
+
+#define BB_DECODE_BATCH         1024
+#define BB_DECODE_MAX_THREADS   64
+
+typedef struct bb_decode_job bb_decode_job_t;
+
+struct bb_decode_job {
+  bytebuffer_t *    bb;
+  bb_index_t *      idx;
+  bb_record_cb      cb;
+  void *            arg;
+  size_t            next;
+};
+
+static void * bb_decode_worker (void *p)
+{
+  bb_decode_job_t *job = p;
+  bytebuffer_t view;
+  size_t count = job->idx->count;
+  size_t n;
+
+  while ((n = __atomic_fetch_add(&job->next, BB_DECODE_BATCH,
+          __ATOMIC_RELAXED)) < count) {
+    size_t end = n + BB_DECODE_BATCH < count ? n + BB_DECODE_BATCH : count;
+    for (; n < end; ++n) {
+      (void) bb_record_at(job->bb, job->idx, n, &view);
+      job->cb(&view, n, job->arg);
+    }
+  }
+
+  return NULL;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_decode_parallel: call cb for every indexed record using nthreads threads
+// (the caller included; nthreads <= 0 means one per online cpu)
+int bb_decode_parallel (bytebuffer_t *bb, bb_index_t *idx, bb_record_cb cb,
+    void *arg, int nthreads)
+{
+  pthread_t tid [BB_DECODE_MAX_THREADS];
+  bb_decode_job_t job = { bb, idx, cb, arg, 0 };
+  int started = 0;
+
+  if (cb == NULL) return -1;
+
+  if (nthreads <= 0) nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads < 1) nthreads = 1;
+
+  // no point in starting more threads than there are batches; the cap on
+  // tid [] goes last
+  size_t batches = (idx->count + BB_DECODE_BATCH - 1) / BB_DECODE_BATCH;
+  if ((size_t) nthreads > batches) nthreads = (int) batches;
+  if (nthreads > BB_DECODE_MAX_THREADS) nthreads = BB_DECODE_MAX_THREADS;
+
+  while (started < nthreads - 1 &&
+      pthread_create(&tid[started], NULL, bb_decode_worker, &job) == 0)
+    ++started;
+
+  (void) bb_decode_worker(&job);
+
+  for (int i = 0; i < started; ++i) (void) pthread_join(tid[i], NULL);
+
+  return 1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// streaming reader / writer
+//
+// A stream owns depth page-aligned bytebuffers of chunk bytes.  Reads are
+// issued depth chunks ahead and writes are queued behind the caller, so I/O
+// on the other buffers overlaps decoding / encoding of the current one.
+// The I/O goes through io_uring (raw syscalls, no liburing) when the kernel
+// allows it, else through a small pool of threads doing pread / pwrite.
+// Offsets are explicit, so the descriptor must be seekable; on close its
+// position is left just past the data read or written.
+
+#define BB_STREAM_MAX_DEPTH     64
+#define BB_STREAM_MAX_THREADS   8
+#define BB_STREAM_MAX_CHUNK     (1UL << 30)
+
+typedef struct bb_stream_slot bb_stream_slot_t;
+
+struct bb_stream_slot {
+  bytebuffer_t      bb;
+  off_t             offset;
+  size_t            length;
+  ssize_t           result;     // bytes transferred or -errno
+  int               busy;       // submitted and not yet waited for
+  int               done;       // result is set
+};
+
+typedef struct bb_uring bb_uring_t;
+
+struct bb_uring {
+  int                     fd;
+  void *                  sq_ptr;
+  size_t                  sq_len;
+  void *                  cq_ptr;
+  size_t                  cq_len;
+  struct io_uring_sqe *   sqes;
+  size_t                  sqes_len;
+  unsigned *              sq_tail;
+  unsigned *              sq_mask;
+  unsigned *              sq_array;
+  unsigned *              cq_head;
+  unsigned *              cq_tail;
+  unsigned *              cq_mask;
+  struct io_uring_cqe *   cqes;
+};
+
+struct bb_stream {
+  int                 fd;
+  uint32_t            mode;
+  size_t              chunk;
+  int                 depth;
+  off_t               offset;     // file offset of the next submit
+  off_t               pos;        // file offset just past the caller's data
+  int                 next;       // slot handed to the caller next
+  int                 held;       // slot held by the caller (-1 if none)
+  int                 eof;
+  int                 error;      // first errno seen (0 if none)
+  bb_stream_slot_t    slot [BB_STREAM_MAX_DEPTH];
+  // io_uring backend
+  int                 use_uring;
+  bb_uring_t          ring;
+  // thread pool backend
+  pthread_mutex_t     lock;
+  pthread_cond_t      work;
+  pthread_cond_t      done;
+  int                 queue [BB_STREAM_MAX_DEPTH];
+  int                 q_head;
+  int                 q_count;
+  int                 stop;
+  int                 nthreads;
+  pthread_t           tid [BB_STREAM_MAX_THREADS];
+};
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_io: move sl->length bytes starting done bytes in, synchronously
+static ssize_t bb_stream_io (bb_stream_t *s, bb_stream_slot_t *sl, size_t done)
+{
+  byte_t *buffer = sl->bb.buffer;
+
+  while (done < sl->length) {
+    ssize_t n = (s->mode & BB_STREAM_WRITE)
+      ? pwrite(s->fd, buffer + done, sl->length - done, sl->offset + done)
+      : pread(s->fd, buffer + done, sl->length - done, sl->offset + done);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -errno;
+    }
+    if (n == 0) break;
+    done += n;
+  }
+
+  return done;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// io_uring backend
+//
+// 1 if the ring supports IORING_OP_READ and IORING_OP_WRITE (5.6+).  Older
+// kernels set up a ring but fail every such request with EINVAL, and they
+// also lack IORING_REGISTER_PROBE, so any error here means no.
+static int bb_uring_probe (int fd)
+{
+  size_t len = sizeof(struct io_uring_probe) +
+    IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe *probe = calloc(1, len);
+  int ok = 0;
+
+  if (probe == NULL) return 0;
+
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+        IORING_OP_LAST) == 0 &&
+      probe->last_op >= IORING_OP_WRITE &&
+      (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+      (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED))
+    ok = 1;
+
+  free(probe);
+
+  return ok;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static int bb_uring_init (bb_uring_t *r, unsigned entries)
+{
+  struct io_uring_params p;
+
+  memset(&p, 0, sizeof(p));
+  memset(r, 0, sizeof(bb_uring_t));
+
+  r->fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+  if (r->fd < 0) return -1;
+
+  // no READ/WRITE opcodes: let bb_stream_open fall back to the thread pool
+  if (!bb_uring_probe(r->fd)) goto close_ring;
+
+  r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (r->cq_len > r->sq_len) r->sq_len = r->cq_len;
+    r->cq_len = r->sq_len;
+  }
+
+  r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  if (r->sq_ptr == MAP_FAILED) goto close_ring;
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    r->cq_ptr = r->sq_ptr;
+  } else {
+    r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    if (r->cq_ptr == MAP_FAILED) goto unmap_sq;
+  }
+
+  r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+  if (r->sqes == MAP_FAILED) goto unmap_cq;
+
+  r->sq_tail = (unsigned *) ((char *) r->sq_ptr + p.sq_off.tail);
+  r->sq_mask = (unsigned *) ((char *) r->sq_ptr + p.sq_off.ring_mask);
+  r->sq_array = (unsigned *) ((char *) r->sq_ptr + p.sq_off.array);
+  r->cq_head = (unsigned *) ((char *) r->cq_ptr + p.cq_off.head);
+  r->cq_tail = (unsigned *) ((char *) r->cq_ptr + p.cq_off.tail);
+  r->cq_mask = (unsigned *) ((char *) r->cq_ptr + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *) ((char *) r->cq_ptr + p.cq_off.cqes);
+
+  return 1;
+
+unmap_cq:
+  if (r->cq_ptr != r->sq_ptr) (void) munmap(r->cq_ptr, r->cq_len);
+unmap_sq:
+  (void) munmap(r->sq_ptr, r->sq_len);
+close_ring:
+  (void) close(r->fd);
+  return -1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static void bb_uring_term (bb_uring_t *r)
+{
+  (void) munmap(r->sqes, r->sqes_len);
+  if (r->cq_ptr != r->sq_ptr) (void) munmap(r->cq_ptr, r->cq_len);
+  (void) munmap(r->sq_ptr, r->sq_len);
+  (void) close(r->fd);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static int bb_uring_submit (bb_stream_t *s, int i)
+{
+  bb_uring_t *r = &s->ring;
+  bb_stream_slot_t *sl = &s->slot[i];
+  unsigned tail = *r->sq_tail;
+  unsigned index = tail & *r->sq_mask;
+  struct io_uring_sqe *sqe = &r->sqes[index];
+
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->opcode = (s->mode & BB_STREAM_WRITE) ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = s->fd;
+  sqe->addr = (uint64_t) (uintptr_t) sl->bb.buffer;
+  sqe->len = (uint32_t) sl->length;
+  sqe->off = (uint64_t) sl->offset;
+  sqe->user_data = (uint64_t) i;
+  r->sq_array[index] = index;
+  __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  long n;
+  while ((n = syscall(__NR_io_uring_enter, r->fd, 1, 0, 0, NULL, 0)) < 0 &&
+      errno == EINTR)
+    ;
+
+  // not consumed: take the entry back out of the ring so a later enter
+  // cannot submit it for a slot that has since been reused or released
+  if (n != 1) {
+    if (n == 0) errno = EAGAIN;
+    __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+    return -1;
+  }
+
+  return 1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_uring_wait: reap completions (for any slot) until sl is done
+//
+// The kernel owns sl's buffer until its completion is reaped, so this never
+// gives up on it: if io_uring_enter fails, the ring is polled instead.
+static void bb_uring_wait (bb_stream_t *s, bb_stream_slot_t *sl)
+{
+  bb_uring_t *r = &s->ring;
+  int polling = 0;
+
+  while (!sl->done) {
+    unsigned head = *r->cq_head;
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+      if (polling) (void) sched_yield();
+      else if (syscall(__NR_io_uring_enter, r->fd, 0, 1,
+            IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+        polling = 1;
+      continue;
+    }
+    struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+    bb_stream_slot_t *x = &s->slot[cqe->user_data];
+    x->result = cqe->res;
+    x->done = 1;
+    __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+  }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// thread pool backend
+static void * bb_stream_worker (void *p)
+{
+  bb_stream_t *s = p;
+
+  (void) pthread_mutex_lock(&s->lock);
+  for (;;) {
+    while (!s->stop && s->q_count == 0)
+      (void) pthread_cond_wait(&s->work, &s->lock);
+    if (s->q_count == 0) break;
+    bb_stream_slot_t *sl = &s->slot[s->queue[s->q_head]];
+    s->q_head = (s->q_head + 1) % BB_STREAM_MAX_DEPTH;
+    --s->q_count;
+    (void) pthread_mutex_unlock(&s->lock);
+
+    ssize_t result = bb_stream_io(s, sl, 0);
+
+    (void) pthread_mutex_lock(&s->lock);
+    sl->result = result;
+    sl->done = 1;
+    (void) pthread_cond_broadcast(&s->done);
+  }
+  (void) pthread_mutex_unlock(&s->lock);
+
+  return NULL;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static void bb_pool_term (bb_stream_t *s)
+{
+  (void) pthread_mutex_lock(&s->lock);
+  s->stop = 1;
+  (void) pthread_cond_broadcast(&s->work);
+  (void) pthread_mutex_unlock(&s->lock);
+
+  for (int i = 0; i < s->nthreads; ++i) (void) pthread_join(s->tid[i], NULL);
+
+  (void) pthread_cond_destroy(&s->done);
+  (void) pthread_cond_destroy(&s->work);
+  (void) pthread_mutex_destroy(&s->lock);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static int bb_pool_init (bb_stream_t *s)
+{
+  int n = s->depth < BB_STREAM_MAX_THREADS ? s->depth : BB_STREAM_MAX_THREADS;
+
+  (void) pthread_mutex_init(&s->lock, NULL);
+  (void) pthread_cond_init(&s->work, NULL);
+  (void) pthread_cond_init(&s->done, NULL);
+
+  while (s->nthreads < n &&
+      pthread_create(&s->tid[s->nthreads], NULL, bb_stream_worker, s) == 0)
+    ++s->nthreads;
+
+  if (s->nthreads == 0) {
+    bb_pool_term(s);
+    return -1;
+  }
+
+  return 1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static void bb_pool_submit (bb_stream_t *s, int i)
+{
+  (void) pthread_mutex_lock(&s->lock);
+  s->queue[(s->q_head + s->q_count) % BB_STREAM_MAX_DEPTH] = i;
+  ++s->q_count;
+  (void) pthread_cond_signal(&s->work);
+  (void) pthread_mutex_unlock(&s->lock);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+static void bb_pool_wait (bb_stream_t *s, bb_stream_slot_t *sl)
+{
+  (void) pthread_mutex_lock(&s->lock);
+  while (!sl->done) (void) pthread_cond_wait(&s->done, &s->lock);
+  (void) pthread_mutex_unlock(&s->lock);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_submit: start the transfer of length bytes of slot i at offset
+static void bb_stream_submit (bb_stream_t *s, int i, size_t length)
+{
+  bb_stream_slot_t *sl = &s->slot[i];
+
+  sl->offset = s->offset;
+  sl->length = length;
+  sl->result = 0;
+  sl->done = 0;
+  sl->busy = 1;
+  s->offset += length;
+
+  if (!s->use_uring) {
+    bb_pool_submit(s, i);
+  } else if (bb_uring_submit(s, i) != 1) {
+    sl->result = -errno;
+    sl->done = 1;
+  }
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_wait: wait for slot i; return bytes transferred or -1 (errno set)
+static ssize_t bb_stream_wait (bb_stream_t *s, int i)
+{
+  bb_stream_slot_t *sl = &s->slot[i];
+
+  if (!s->use_uring) bb_pool_wait(s, sl);
+  else bb_uring_wait(s, sl);
+
+  sl->busy = 0;
+
+  // finish a short transfer that did not reach the end of the file
+  if (sl->result > 0 && (size_t) sl->result < sl->length)
+    sl->result = bb_stream_io(s, sl, sl->result);
+
+  if (sl->result < 0) {
+    errno = (int) -sl->result;
+    if (s->error == 0) s->error = errno;
+    return -1;
+  }
+
+  return sl->result;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_open: open a reader (BB_STREAM_READ) or writer (BB_STREAM_WRITE)
+// of depth buffers of chunk bytes over fd, starting at its current offset
+bb_stream_t * bb_stream_open (int fd, uint32_t mode, size_t chunk, int depth)
+{
+  if (chunk == 0 || chunk > BB_STREAM_MAX_CHUNK) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  off_t start = lseek(fd, 0, SEEK_CUR);
+  if (start < 0) return NULL;
+
+  bb_stream_t *s = calloc(1, sizeof(bb_stream_t));
+  if (s == NULL) return NULL;
+
+  if (depth < 2) depth = 2;
+  if (depth > BB_STREAM_MAX_DEPTH) depth = BB_STREAM_MAX_DEPTH;
+
+  s->fd = fd;
+  s->mode = mode;
+  s->chunk = chunk;
+  s->depth = depth;
+  s->offset = start;
+  s->pos = start;
+  s->held = -1;
+
+  for (int i = 0; i < depth; ++i) {
+    if (bb_init_ex(&s->slot[i].bb, chunk, BB_ALLOC_ALIGN_PAGE, -1) != 1) {
+      while (i-- > 0) bb_term(&s->slot[i].bb);
+      free(s);
+      errno = ENOMEM;
+      return NULL;
+    }
+  }
+
+  if (!(mode & BB_STREAM_THREADS) && bb_uring_init(&s->ring, depth) == 1)
+    s->use_uring = 1;
+  else if (bb_pool_init(s) != 1) {
+    for (int i = 0; i < depth; ++i) bb_term(&s->slot[i].bb);
+    free(s);
+    errno = EAGAIN;
+    return NULL;
+  }
+
+  // a reader starts depth chunks ahead
+  if (!(mode & BB_STREAM_WRITE))
+    for (int i = 0; i < depth; ++i) bb_stream_submit(s, i, chunk);
+
+  return s;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_next (reader): hand back the previous buffer and return the next
+// chunk, flipped (index 0, bound = bytes read); NULL at end of file or error
+static bytebuffer_t * bb_stream_next_read (bb_stream_t *s)
+{
+  // the buffer the caller is done with reads the chunk depth ahead
+  if (s->held >= 0) {
+    if (!s->eof && s->error == 0) bb_stream_submit(s, s->held, s->chunk);
+    s->held = -1;
+  }
+
+  bb_stream_slot_t *sl = &s->slot[s->next];
+  if (s->error != 0 || !sl->busy) return NULL;
+
+  ssize_t n = bb_stream_wait(s, s->next);
+  if (n <= 0) {
+    s->eof = 1;
+    return NULL;
+  }
+  if ((size_t) n < s->chunk) s->eof = 1;
+
+  bb_clear(&sl->bb);
+  bb_set_index(&sl->bb, n);
+  bb_flip(&sl->bb);
+
+  s->pos = sl->offset + n;
+  s->held = s->next;
+  s->next = (s->next + 1) % s->depth;
+
+  return &sl->bb;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_filled: bytes to write from a buffer the writer handed out.  It
+// is meant to be filled and not flipped (index bytes), but one the caller
+// flipped anyway (index 0, bound below size) is written, not dropped.
+static size_t bb_stream_filled (bytebuffer_t *bb)
+{
+  if (bb->index == 0 && bb->bound < bb->size) return bb->bound;
+
+  return bb->index;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_next (writer): queue the previous buffer and return a cleared one
+// to fill; NULL if a write failed
+static bytebuffer_t * bb_stream_next_write (bb_stream_t *s)
+{
+  if (s->held >= 0) {
+    bb_stream_slot_t *held = &s->slot[s->held];
+    size_t n = bb_stream_filled(&held->bb);
+    if (n > 0) {
+      bb_stream_submit(s, s->held, n);
+      s->next = (s->held + 1) % s->depth;
+    }
+    s->held = -1;
+  }
+
+  bb_stream_slot_t *sl = &s->slot[s->next];
+  if (sl->busy) {
+    ssize_t n = bb_stream_wait(s, s->next);
+    if (n >= 0 && (size_t) n != sl->length) {
+      errno = EIO;
+      if (s->error == 0) s->error = errno;
+    }
+  }
+  if (s->error != 0) return NULL;
+
+  bb_clear(&sl->bb);
+  s->held = s->next;
+
+  return &sl->bb;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+bytebuffer_t * bb_stream_next (bb_stream_t *s)
+{
+  return (s->mode & BB_STREAM_WRITE)
+    ? bb_stream_next_write(s) : bb_stream_next_read(s);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// bb_stream_close: write out the held buffer (writer), wait for everything in
+// flight and release the stream; returns 1 or -1 if any transfer failed
+int bb_stream_close (bb_stream_t *s)
+{
+  if ((s->mode & BB_STREAM_WRITE) && s->held >= 0) {
+    bb_stream_slot_t *held = &s->slot[s->held];
+    size_t n = bb_stream_filled(&held->bb);
+    if (n > 0 && s->error == 0) bb_stream_submit(s, s->held, n);
+  }
+
+  for (int i = 0; i < s->depth; ++i) {
+    bb_stream_slot_t *sl = &s->slot[i];
+    if (!sl->busy) continue;
+    ssize_t n = bb_stream_wait(s, i);
+    if ((s->mode & BB_STREAM_WRITE) && n >= 0 && (size_t) n != sl->length
+        && s->error == 0) s->error = EIO;
+  }
+
+  if (s->mode & BB_STREAM_WRITE) s->pos = s->offset;
+  if (s->error == 0) (void) lseek(s->fd, s->pos, SEEK_SET);
+
+  if (s->use_uring) bb_uring_term(&s->ring);
+  else bb_pool_term(s);
+
+  for (int i = 0; i < s->depth; ++i) bb_term(&s->slot[i].bb);
+
+  int error = s->error;
+  free(s);
+
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  return 1;
+}
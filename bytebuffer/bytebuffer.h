@@ -22,6 +22,7 @@
 
 #include <unistd.h>
 #include <endian.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -36,6 +37,10 @@
 
 #define BUFFER_STRING_SIZE  255
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 //
 typedef uint8_t bool_t;
@@ -59,10 +64,10 @@ uint32_t const  SHIFT_40  = 40;
 uint32_t const  SHIFT_48  = 48;
 uint32_t const  SHIFT_56  = 56;
 
-typedef enum byte_order byte_order_t;
-
 enum byte_order { NONE, BIG_END=1, LITTLE_END=4 };
 
+typedef enum byte_order byte_order_t;
+
 byte_order_t bb_native_byte_order (void);
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -70,6 +75,21 @@ byte_order_t bb_native_byte_order (void);
 
 typedef void (*bb_commit_cb) (void);
 
+// allocation flags for bb_init_ex (may be OR'd together)
+enum bb_alloc_flag {
+  BB_ALLOC_DEFAULT    = 0x00,   // calloc (same as bb_init)
+  BB_ALLOC_ALIGN_64   = 0x01,   // cache-line aligned heap buffer
+  BB_ALLOC_ALIGN_PAGE = 0x02,   // page aligned anonymous mapping
+  BB_ALLOC_HUGEPAGE   = 0x04,   // size >= 2MB: MAP_HUGETLB, THP advice if that
+                                // fails; smaller sizes get a plain mapping
+  BB_ALLOC_NUMA_NODE  = 0x08,   // prefer the node passed to bb_init_ex (kept
+                                // unbound if mbind is unavailable; an unknown
+                                // node fails with EINVAL)
+  BB_ALLOC_PREFAULT   = 0x10    // mapped buffer, every page touched up front
+};
+
+typedef enum bb_alloc_flag bb_alloc_flag_t;
+
 typedef struct bytebuffer bytebuffer_t;
 
 struct bytebuffer {
@@ -78,14 +98,40 @@ struct bytebuffer {
   ssize_t       mark;
   size_t        size;
   byte_t *      buffer;
+  size_t        map_size;
+  uint64_t      bit_acc;
+  size_t        bit_count;
 };
 
+// map_size of a bytebuffer that does not own its buffer (sbo storage or a
+// record view); bb_term leaves such a buffer alone
+#define BB_MAP_VIEW ((size_t) -1)
+
 #define bb_alloc() (calloc(1, sizeof(bytebuffer_t)))
 #define bb_free(P) (free(P), P = NULL)
 
 int bb_init (bytebuffer_t *, size_t, bb_commit_cb);
+int bb_init_ex (bytebuffer_t *, size_t, uint32_t, int);
 void bb_term (bytebuffer_t *);
 
+// small buffer optimization: a size up to BB_SBO_CAPACITY is stored inline,
+// right after the header; a larger size is heap allocated as by bb_init.
+// Pass &sbo->bb to the bb_* functions.  Do not copy a bytebuffer_sbo_t by
+// value: its buffer points into its own storage.
+
+#define BB_SBO_CAPACITY 64
+
+typedef struct bytebuffer_sbo bytebuffer_sbo_t;
+
+struct bytebuffer_sbo {
+  bytebuffer_t  bb;
+  byte_t        storage[BB_SBO_CAPACITY];
+} __attribute__ ((aligned (128)));
+
+#define bb_sbo_alloc() (aligned_alloc(128, sizeof(bytebuffer_sbo_t)))
+
+int bb_sbo_init (bytebuffer_sbo_t *, size_t, bb_commit_cb);
+
 size_t bb_get_bound (bytebuffer_t *);
 byte_t* bb_get_buffer (bytebuffer_t *);
 size_t bb_get_index (bytebuffer_t *);
@@ -147,4 +193,102 @@ void bb_put_uint64_at (bytebuffer_t *, size_t, uint64_t);
 void bb_put_varchar (bytebuffer_t *, char const *);
 void bb_put_varchar_at (bytebuffer_t *, size_t, char const *);
 
+// bit stream (LSB first; call bb_put_bits_align before bb_flip)
+void bb_put_bits (bytebuffer_t *, uint64_t, uint32_t);
+void bb_put_bits_align (bytebuffer_t *);
+void bb_put_bits_array (bytebuffer_t *, uint32_t const *, size_t, uint32_t);
+uint64_t bb_get_bits (bytebuffer_t *, uint32_t);
+void bb_get_bits_align (bytebuffer_t *);
+void bb_get_bits_array (bytebuffer_t *, uint32_t *, size_t, uint32_t);
+
+// half (IEEE binary16) and bfloat16, 2 bytes each
+float bb_get_half (bytebuffer_t *);
+float bb_get_half_at (bytebuffer_t *, size_t);
+void bb_get_half_array (bytebuffer_t *, float *, size_t);
+float bb_get_bf16 (bytebuffer_t *);
+float bb_get_bf16_at (bytebuffer_t *, size_t);
+void bb_get_bf16_array (bytebuffer_t *, float *, size_t);
+void bb_put_half (bytebuffer_t *, float);
+void bb_put_half_at (bytebuffer_t *, size_t, float);
+void bb_put_half_array (bytebuffer_t *, float const *, size_t);
+void bb_put_bf16 (bytebuffer_t *, float);
+void bb_put_bf16_at (bytebuffer_t *, size_t, float);
+void bb_put_bf16_array (bytebuffer_t *, float const *, size_t);
+
+// int64 delta arrays (count is not stored; pass the same count to get)
+void bb_put_int64_delta_array (bytebuffer_t *, int64_t const *, size_t);
+void bb_get_int64_delta_array (bytebuffer_t *, int64_t *, size_t);
+void bb_put_int64_for_array (bytebuffer_t *, int64_t const *, size_t);
+void bb_get_int64_for_array (bytebuffer_t *, int64_t *, size_t);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// record index (a record is a uint32_t length followed by that many bytes)
+
+typedef struct bb_index bb_index_t;
+
+struct bb_index {
+  size_t *      offset;     // offset of each record's length prefix
+  size_t        count;
+  size_t        capacity;
+};
+
+// called once per record with a read cursor (view) over its payload
+typedef void (*bb_record_cb) (bytebuffer_t *, size_t, void *);
+
+ssize_t bb_build_index (bytebuffer_t *, bb_index_t *);
+void bb_index_term (bb_index_t *);
+int bb_record_at (bytebuffer_t *, bb_index_t *, size_t, bytebuffer_t *);
+int bb_decode_parallel (bytebuffer_t *, bb_index_t *, bb_record_cb, void *,
+    int);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// struct of arrays: count rows of stride bytes are written one field at a
+// time (every value of the first field, then the second, ...).  A layout is
+// an array of fields ended by BB_FIELD_END, e.g.
+//
+//   bb_field_t const layout [] = {
+//     BB_FIELD(tick_t, time), BB_FIELD(tick_t, price), BB_FIELD_END };
+
+typedef struct bb_field bb_field_t;
+
+struct bb_field {
+  uint32_t      offset;
+  uint32_t      size;
+};
+
+#define BB_FIELD(T, M) { offsetof(T, M), sizeof(((T *) 0)->M) }
+#define BB_FIELD_END { 0, 0 }
+
+void bb_put_soa (bytebuffer_t *, void const *, size_t, size_t,
+    bb_field_t const *);
+void bb_get_aos (bytebuffer_t *, void *, size_t, size_t, bb_field_t const *);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// streaming reader / writer with depth buffers in flight (io_uring, else a
+// thread pool).  bb_stream_next returns the next filled, flipped buffer
+// (reader) or a cleared buffer to fill (writer); the buffer it returned
+// before goes back to the stream.  fd must be seekable.
+//
+// A writer's buffer must not be flipped: the next bb_stream_next or
+// bb_stream_close writes bytes [0, index).  A buffer flipped anyway is still
+// written unless it was completely full, which looks like an empty one.
+
+typedef struct bb_stream bb_stream_t;
+
+enum bb_stream_flag {
+  BB_STREAM_READ      = 0x00,
+  BB_STREAM_WRITE     = 0x01,
+  BB_STREAM_THREADS   = 0x02    // use the thread pool even if io_uring works
+};
+
+typedef enum bb_stream_flag bb_stream_flag_t;
+
+bb_stream_t * bb_stream_open (int, uint32_t, size_t, int);
+bytebuffer_t * bb_stream_next (bb_stream_t *);
+int bb_stream_close (bb_stream_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,313 @@
+/*------------------------------------------------------------------------------
+    ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+
+    Copyright (C) 2025  J. McIntosh
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+------------------------------------------------------------------------------*/
+#ifndef BYTEBUFFER_HPP
+#define BYTEBUFFER_HPP  1
+
+// header-only C++17 layer over bytebuffer.h
+//
+// ByteBuffer owns its storage (bb_init_ex / bb_term) and is move-only.
+// ByteView is a cursor over writable storage owned by someone else, and
+// ConstByteView a read-only one (no put, put_at, clear or flip).  All of
+// them hold a single bytebuffer_t, so native() can be passed to any bb_*
+// function and the C and C++ sides always agree on index and bound.
+//
+// put/get are inline: a value is one bounds check and one load or store in
+// the requested byte order.  The C functions store little endian, which is
+// also the default here.  As in the C library, a put that does not fit is
+// ignored and a get past the bound returns T{}.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#if __has_include(<span>)
+#include <span>
+#endif
+
+#include "bytebuffer.h"
+
+namespace bb {
+
+enum class Endian {
+  Little,
+  Big,
+  Native = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? Little : Big
+};
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ||
+    __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__, "byte order");
+
+namespace detail {
+
+template<class T>
+inline constexpr bool is_value_v =
+    (std::is_arithmetic_v<T> || std::is_enum_v<T>) &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// value in byte order E (its own inverse)
+template<Endian E, class T>
+inline T order (T v) noexcept
+{
+  if constexpr (E == Endian::Native || sizeof(T) == 1) {
+    return v;
+  } else if constexpr (sizeof(T) == 2) {
+    uint16_t u; std::memcpy(&u, &v, 2); u = __builtin_bswap16(u);
+    std::memcpy(&v, &u, 2); return v;
+  } else if constexpr (sizeof(T) == 4) {
+    uint32_t u; std::memcpy(&u, &v, 4); u = __builtin_bswap32(u);
+    std::memcpy(&v, &u, 4); return v;
+  } else {
+    uint64_t u; std::memcpy(&u, &v, 8); u = __builtin_bswap64(u);
+    std::memcpy(&v, &u, 8); return v;
+  }
+}
+
+} // namespace detail
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ReadCursor: the state and read accessors shared by every buffer type
+//
+// native() is not const so that the bb_get_* functions can advance the
+// index; through a ConstByteView it must only be passed to functions that
+// read the storage.
+class ReadCursor {
+public:
+  bytebuffer_t * native () noexcept { return &bb_; }
+  bytebuffer_t const * native () const noexcept { return &bb_; }
+
+  byte_t const * data () const noexcept { return bb_.buffer; }
+  size_t bound () const noexcept { return bb_.bound; }
+  size_t index () const noexcept { return bb_.index; }
+  size_t size () const noexcept { return bb_.size; }
+  size_t remaining () const noexcept {
+    return bb_.index < bb_.bound ? bb_.bound - bb_.index : 0;
+  }
+  bool has_more () const noexcept { return bb_.index < bb_.bound; }
+
+  void set_index (size_t i) noexcept { bb_set_index(&bb_, i); }
+
+  // single values
+
+  template<class T, Endian E = Endian::Little>
+  T get () noexcept {
+    static_assert(detail::is_value_v<T>, "get: 1, 2, 4 or 8 byte scalar");
+    T v{};
+    if (remaining() < sizeof(T)) return v;
+    std::memcpy(&v, bb_.buffer + bb_.index, sizeof(T));
+    bb_.index += sizeof(T);
+    return detail::order<E>(v);
+  }
+
+  template<class T, Endian E = Endian::Little>
+  T get_at (size_t at) const noexcept {
+    static_assert(detail::is_value_v<T>, "get_at: 1, 2, 4 or 8 byte scalar");
+    T v{};
+    if (at > bb_.bound || bb_.bound - at < sizeof(T)) return v;
+    std::memcpy(&v, bb_.buffer + at, sizeof(T));
+    return detail::order<E>(v);
+  }
+
+  // arrays (all or nothing; one copy when E is the native order)
+
+  template<Endian E = Endian::Little, class T>
+  void get (T *dst, size_t n) noexcept {
+    static_assert(detail::is_value_v<T>, "get: 1, 2, 4 or 8 byte scalar");
+    if (n > remaining() / sizeof(T)) return;
+    byte_t const *p = bb_.buffer + bb_.index;
+    if constexpr (E == Endian::Native || sizeof(T) == 1) {
+      std::memcpy(dst, p, n * sizeof(T));
+    } else {
+      for (size_t i = 0; i < n; ++i, p += sizeof(T)) {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        dst[i] = detail::order<E>(v);
+      }
+    }
+    bb_.index += n * sizeof(T);
+  }
+
+#ifdef __cpp_lib_span
+  template<Endian E = Endian::Little, class T, size_t N>
+  void get (std::span<T, N> s) noexcept {
+    static_assert(!std::is_const_v<T>, "get: span of const");
+    get<E>(s.data(), s.size());
+  }
+#endif
+
+protected:
+  ReadCursor () noexcept : bb_{} { bb_.mark = -1; }
+
+  bytebuffer_t  bb_;
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Cursor: adds the write accessors shared by ByteBuffer and ByteView
+class Cursor : public ReadCursor {
+public:
+  byte_t * data () const noexcept { return bb_.buffer; }
+
+  void clear () noexcept { bb_clear(&bb_); }
+  void flip () noexcept { bb_flip(&bb_); }
+
+  // single values
+
+  template<class T, Endian E = Endian::Little>
+  void put (T v) noexcept {
+    static_assert(detail::is_value_v<T>, "put: 1, 2, 4 or 8 byte scalar");
+    if (remaining() < sizeof(T)) return;
+    v = detail::order<E>(v);
+    std::memcpy(bb_.buffer + bb_.index, &v, sizeof(T));
+    bb_.index += sizeof(T);
+  }
+
+  template<class T, Endian E = Endian::Little>
+  void put_at (size_t at, T v) noexcept {
+    static_assert(detail::is_value_v<T>, "put_at: 1, 2, 4 or 8 byte scalar");
+    if (at > bb_.bound || bb_.bound - at < sizeof(T)) return;
+    v = detail::order<E>(v);
+    std::memcpy(bb_.buffer + at, &v, sizeof(T));
+  }
+
+  // arrays (all or nothing; one copy when E is the native order)
+
+  template<Endian E = Endian::Little, class T>
+  void put (T const *src, size_t n) noexcept {
+    static_assert(detail::is_value_v<T>, "put: 1, 2, 4 or 8 byte scalar");
+    if (n > remaining() / sizeof(T)) return;
+    byte_t *p = bb_.buffer + bb_.index;
+    if constexpr (E == Endian::Native || sizeof(T) == 1) {
+      std::memcpy(p, src, n * sizeof(T));
+    } else {
+      for (size_t i = 0; i < n; ++i, p += sizeof(T)) {
+        T v = detail::order<E>(src[i]);
+        std::memcpy(p, &v, sizeof(T));
+      }
+    }
+    bb_.index += n * sizeof(T);
+  }
+
+#ifdef __cpp_lib_span
+  template<Endian E = Endian::Little, class T, size_t N>
+  void put (std::span<T, N> s) noexcept { put<E>(s.data(), s.size()); }
+#endif
+
+protected:
+  Cursor () noexcept = default;
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ByteBuffer: owns its storage
+class ByteBuffer : public Cursor {
+public:
+  explicit ByteBuffer (size_t size, uint32_t flags = BB_ALLOC_DEFAULT,
+      int node = -1) {
+    if (bb_init_ex(&bb_, size, flags, node) != 1) throw std::bad_alloc();
+  }
+
+  ~ByteBuffer () { if (bb_.buffer != nullptr) bb_term(&bb_); }
+
+  ByteBuffer (ByteBuffer const &) = delete;
+  ByteBuffer & operator= (ByteBuffer const &) = delete;
+
+  ByteBuffer (ByteBuffer &&other) noexcept {
+    bb_ = other.bb_;
+    other.bb_ = bytebuffer_t{};
+  }
+
+  ByteBuffer & operator= (ByteBuffer &&other) noexcept {
+    if (this != &other) {
+      if (bb_.buffer != nullptr) bb_term(&bb_);
+      bb_ = other.bb_;
+      other.bb_ = bytebuffer_t{};
+    }
+    return *this;
+  }
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ByteView: a cursor over writable storage it does not own (copyable)
+class ByteView : public Cursor {
+public:
+  ByteView (void *p, size_t n) noexcept {
+    bb_.buffer = static_cast<byte_t *>(p);
+    bb_.bound = n;
+    bb_.size = n;
+    bb_.map_size = BB_MAP_VIEW;
+  }
+
+  // same storage, index and bound as b, with a cursor of its own
+  explicit ByteView (bytebuffer_t const &b) noexcept
+    : ByteView(b.buffer, b.bound) { bb_.index = b.index; }
+
+  explicit ByteView (Cursor const &c) noexcept : ByteView(*c.native()) { }
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ConstByteView: a read-only cursor over storage it does not own (copyable)
+//
+// bytebuffer_t has no const variant, so the pointer is stored without its
+// const; nothing reachable from this type writes through it.
+class ConstByteView : public ReadCursor {
+public:
+  ConstByteView (void const *p, size_t n) noexcept {
+    bb_.buffer = static_cast<byte_t *>(const_cast<void *>(p));
+    bb_.bound = n;
+    bb_.size = n;
+    bb_.map_size = BB_MAP_VIEW;
+  }
+
+  // same storage, index and bound as b, with a cursor of its own
+  explicit ConstByteView (bytebuffer_t const &b) noexcept
+    : ConstByteView(b.buffer, b.bound) { bb_.index = b.index; }
+
+  explicit ConstByteView (ReadCursor const &c) noexcept
+    : ConstByteView(*c.native()) { }
+};
+
+static_assert(sizeof(Cursor) == sizeof(bytebuffer_t) &&
+    sizeof(ByteBuffer) == sizeof(bytebuffer_t) &&
+    sizeof(ByteView) == sizeof(bytebuffer_t) &&
+    sizeof(ConstByteView) == sizeof(bytebuffer_t), "layout of bytebuffer_t");
+static_assert(std::is_standard_layout_v<ByteBuffer> &&
+    std::is_standard_layout_v<ByteView> &&
+    std::is_standard_layout_v<ConstByteView>, "layout of bytebuffer_t");
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// streaming (little endian); for records define operator<< on Cursor & and
+// operator>> on ReadCursor &
+
+template<class T, class = std::enable_if_t<detail::is_value_v<T>>>
+inline Cursor & operator<< (Cursor &c, T v) noexcept
+{
+  c.put(v);
+  return c;
+}
+
+template<class T, class = std::enable_if_t<detail::is_value_v<T>>>
+inline ReadCursor & operator>> (ReadCursor &c, T &v) noexcept
+{
+  v = c.get<T>();
+  return c;
+}
+
+} // namespace bb
+
+#endif
@@ -0,0 +1,655 @@
+;-------------------------------------------------------------------------------
+;   ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+;
+;   Copyright (C) 2025  J. McIntosh
+;
+;   This program is free software; you can redistribute it and/or modify
+;   it under the terms of the GNU General Public License as published by
+;   the Free Software Foundation; either version 2 of the License, or
+;   (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License along
+;   with this program; if not, write to the Free Software Foundation, Inc.,
+;   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;-------------------------------------------------------------------------------
+%ifndef DELTA_ASM
+%define DELTA_ASM  1
+;
+; Delta encoding of int64_t arrays.  Both formats start with the first value
+; (8 bytes, little endian) followed by the differences between neighbours:
+;
+; delta:  each difference zigzag encoded as a varint (7 bits per byte, low
+;         group first, high bit set on all but the last byte).
+;
+; for:    blocks of up to BB_DELTA_BLOCK differences.  Each block holds the
+;         smallest difference (8 bytes), the bit width w (1 byte) and then
+;         every (difference - smallest) packed LSB first in w bits, padded
+;         to a byte.
+;
+; The element count is not stored; it is passed to both put and get.  On
+; decode the differences are summed back with an SSE2 prefix sum.
+;
+%include "bytebuffer.inc"
+;
+STACK_BLOCK   EQU     (BB_DELTA_BLOCK * 8)
+;
+section .text
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Pack an array of uint64_t values using w bits for each value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rsi = src
+;   rdx = count (> 0)
+;   rcx = w (0 - 64, every value < 2^w)
+;   rdi = write pointer
+;
+; return:
+;
+;   rdi = write pointer + (count * w + 7) / 8
+;
+; NOTE: rax, rdx, rsi, r8, r9, r11 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+pack64:
+      test      rcx, rcx
+      jz        .return
+; r8 = acc, r9 = bits
+      xor       r8, r8
+      xor       r9, r9
+.next_value:
+; acc |= value << bits; bits += w;
+      mov       rax, QWORD [rsi]
+      add       rsi, 8
+      shlx      r11, rax, r9
+      or        r8, r11
+      add       r9, rcx
+; if (bits < 64) continue;
+      cmp       r9, 64
+      jb        .continue
+; *(uint64_t *) wp = acc; wp += 8; bits -= 64;
+      mov       QWORD [rdi], r8
+      add       rdi, 8
+      sub       r9, 64
+; acc = bits ? value >> (w - bits) : 0;
+      xor       r8, r8
+      test      r9, r9
+      jz        .continue
+      mov       r11, rcx
+      sub       r11, r9
+      shrx      r8, rax, r11
+.continue:
+      dec       rdx
+      jnz       .next_value
+.tail:
+; for (; bits > 0; bits -= 8, acc >>= 8) *wp++ = (byte_t) acc;
+      test      r9, r9
+      jz        .return
+.tail_byte:
+      mov       BYTE [rdi], r8b
+      inc       rdi
+      shr       r8, 8
+      sub       r9, 8
+      ja        .tail_byte
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Unpack an array of uint64_t values of w bits each
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdi = dst
+;   rdx = count (> 0)
+;   rcx = w (0 - 64)
+;   rsi = read pointer
+;   r10 = end of packed data (read pointer + (count * w + 7) / 8)
+;
+; NOTE: rax, rbx, rdx, rsi, rdi, r8, r9, r11, r12 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+unpack64:
+      test      rcx, rcx
+      jnz       .packed
+; w == 0: every value is 0
+      xor       rax, rax
+.zero:
+      mov       QWORD [rdi], rax
+      add       rdi, 8
+      dec       rdx
+      jnz       .zero
+      ret
+.packed:
+; r8 = acc, r9 = bits
+      xor       r8, r8
+      xor       r9, r9
+.next_value:
+; if (bits >= w) goto take;
+      cmp       r9, rcx
+      jae       .take
+; n = min(end - rp, 8);
+      mov       rax, r10
+      sub       rax, rsi
+      cmp       rax, 8
+      jb        .partial
+; word = *(uint64_t *) rp; rp += 8;
+      mov       r11, QWORD [rsi]
+      add       rsi, 8
+      mov       rax, 64
+      jmp       .have_word
+.partial:
+; for (word = 0, i = n; i > 0; --i) word = (word << 8) | rp[i - 1]; rp += n;
+      xor       r11, r11
+      mov       rbx, rax
+.partial_byte:
+      shl       r11, 8
+      movzx     r12d, BYTE [rsi + rbx - 1]
+      or        r11, r12
+      dec       rbx
+      jnz       .partial_byte
+      add       rsi, rax
+      shl       rax, 3
+.have_word:
+; value = (acc | (word << bits)) & mask(w);
+      shlx      r12, r11, r9
+      or        r12, r8
+      bzhi      r12, r12, rcx
+; acc = (w - bits < 64) ? word >> (w - bits) : 0;
+      mov       rbx, rcx
+      sub       rbx, r9
+      xor       r8, r8
+      cmp       rbx, 64
+      jae       .have_acc
+      shrx      r8, r11, rbx
+.have_acc:
+; bits += n * 8 - w;
+      add       r9, rax
+      sub       r9, rcx
+      jmp       .store
+.take:
+; value = acc & mask(w); acc >>= w; bits -= w;
+      mov       r12, r8
+      bzhi      r12, r12, rcx
+      shrx      r8, r8, rcx
+      sub       r9, rcx
+.store:
+; *dst++ = value;
+      mov       QWORD [rdi], r12
+      add       rdi, 8
+      dec       rdx
+      jnz       .next_value
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; In place inclusive prefix sum of an int64_t array
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdi = array
+;   rsi = count
+;
+; NOTE: Two values are summed per pass.  The running total (xmm3) only
+;       depends on the pair sum, so the loop carried chain is one paddq
+;       per two values.  rax, rsi, rdi, xmm0 - xmm3 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+prefix_sum64:
+      pxor      xmm3, xmm3
+.pair:
+      cmp       rsi, 2
+      jb        .tail
+; [a, b] -> [a, a + b]
+      movdqu    xmm0, [rdi]
+      movdqa    xmm1, xmm0
+      pslldq    xmm1, 8
+      paddq     xmm0, xmm1
+; pair sum in both lanes
+      movdqa    xmm2, xmm0
+      punpckhqdq xmm2, xmm2
+; [a, a + b] += total; total += a + b;
+      paddq     xmm0, xmm3
+      movdqu    [rdi], xmm0
+      paddq     xmm3, xmm2
+      add       rdi, 16
+      sub       rsi, 2
+      jmp       .pair
+.tail:
+      test      rsi, rsi
+      jz        .return
+      movq      rax, xmm3
+      add       QWORD [rdi], rax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an int64_t array in bytebuffer as varint deltas
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_int64_delta_array (bytebuffer_t *bb, int64_t const *src,
+;                                  size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = src
+;   rdx = count
+;
+; NOTE: If the encoded array does not fit before the bound, bb->index is
+;       unchanged but the bytes from bb->index up to the bound may already
+;       have been overwritten by the part that did fit.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_int64_delta_array:function
+bb_put_int64_delta_array:
+      push      rbx
+; if (count == 0) return;
+      test      rdx, rdx
+      jz        .return
+; if (bb->index + 8 > bb->bound) return;
+      mov       rbx, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rbx + 8]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; r8 = buffer, r9 = bound, rbx = working index
+      mov       r8, QWORD [rdi + bytebuffer.buffer]
+      mov       r9, QWORD [rdi + bytebuffer.bound]
+; *(int64_t *) &bb->buffer[idx] = prev = src[0]; idx += 8;
+      mov       r10, QWORD [rsi]
+      mov       QWORD [r8 + rbx], r10
+      add       rbx, 8
+      add       rsi, 8
+      dec       rdx
+      jz        .done
+.next_value:
+; d = *src - prev; prev = *src++;
+      mov       rax, QWORD [rsi]
+      mov       r11, rax
+      sub       rax, r10
+      mov       r10, r11
+      add       rsi, 8
+; z = (d << 1) ^ (d >> 63);
+      mov       rcx, rax
+      sar       rcx, 63
+      shl       rax, 1
+      xor       rax, rcx
+.next_byte:
+; if (idx >= bound) return;
+      cmp       rbx, r9
+      jae       .return
+; b = z & 0x7F; z >>= 7; if (z) b |= 0x80; buffer[idx++] = b;
+      mov       ecx, eax
+      and       ecx, 0x7F
+      shr       rax, 7
+      jz        .last_byte
+      or        ecx, 0x80
+      mov       BYTE [r8 + rbx], cl
+      inc       rbx
+      jmp       .next_byte
+.last_byte:
+      mov       BYTE [r8 + rbx], cl
+      inc       rbx
+      dec       rdx
+      jnz       .next_value
+.done:
+; bb->index = idx;
+      mov       QWORD [rdi + bytebuffer.index], rbx
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an int64_t array of varint deltas from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_int64_delta_array (bytebuffer_t *bb, int64_t *dst,
+;                                  size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = dst
+;   rdx = count
+;
+; NOTE: bb->index is unchanged if the data ends (or is malformed) before
+;       count values are decoded.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_int64_delta_array:function
+bb_get_int64_delta_array:
+      push      rbx
+      push      r12
+      push      r13
+; if (count == 0) return;
+      test      rdx, rdx
+      jz        .return
+; if (bb->index + 8 > bb->bound) return;
+      mov       rbx, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rbx + 8]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; r8 = buffer, r9 = bound, rbx = working index, r12 = dst, r13 = count
+      mov       r8, QWORD [rdi + bytebuffer.buffer]
+      mov       r9, QWORD [rdi + bytebuffer.bound]
+      mov       r12, rsi
+      mov       r13, rdx
+; dst[0] = *(int64_t *) &bb->buffer[idx]; idx += 8;
+      mov       rax, QWORD [r8 + rbx]
+      mov       QWORD [rsi], rax
+      add       rbx, 8
+      add       rsi, 8
+      dec       rdx
+      jz        .done
+.next_value:
+; z = 0; shift = 0;
+      xor       r10, r10
+      xor       rcx, rcx
+.next_byte:
+; if (idx >= bound || shift > 63) return;
+      cmp       rbx, r9
+      jae       .return
+      cmp       rcx, 63
+      ja        .return
+; b = buffer[idx++]; z |= (b & 0x7F) << shift; shift += 7;
+      movzx     eax, BYTE [r8 + rbx]
+      inc       rbx
+      mov       r11d, eax
+      and       r11d, 0x7F
+      shlx      r11, r11, rcx
+      or        r10, r11
+      add       rcx, 7
+; while (b & 0x80);
+      test      eax, 0x80
+      jnz       .next_byte
+; *dst++ = (z >> 1) ^ -(z & 1);
+      mov       rax, r10
+      shr       rax, 1
+      and       r10, 1
+      neg       r10
+      xor       rax, r10
+      mov       QWORD [rsi], rax
+      add       rsi, 8
+      dec       rdx
+      jnz       .next_value
+.done:
+; bb->index = idx;
+      mov       QWORD [rdi + bytebuffer.index], rbx
+; prefix_sum64(dst, count);
+      mov       rdi, r12
+      mov       rsi, r13
+      call      prefix_sum64
+.return:
+      pop       r13
+      pop       r12
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an int64_t array in bytebuffer as frame of reference delta blocks
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_int64_for_array (bytebuffer_t *bb, int64_t const *src,
+;                                size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = src
+;   rdx = count
+;
+; stack:
+;
+;   QWORD [rbp - 1024]  = deltas of current block (BB_DELTA_BLOCK)
+;   QWORD [rbp - 1032]  = n (values in current block)
+;
+; NOTE: If the encoded array does not fit before the bound, bb->index is
+;       unchanged but the bytes from bb->index up to the bound may already
+;       have been overwritten by the part that did fit.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_int64_for_array:function
+bb_put_int64_for_array:
+      push      rbp
+      mov       rbp, rsp
+      sub       rsp, STACK_BLOCK + 8
+      push      rbx
+      push      r12
+      push      r13
+      push      r14
+      push      r15
+; if (count == 0) return;
+      test      rdx, rdx
+      jz        .epilogue
+; if (bb->index + 8 > bb->bound) return;
+      mov       rbx, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rbx + 8]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .epilogue
+; r15 = bb, r14 = src, r13 = remaining, r12 = prev, rbx = working index
+      mov       r15, rdi
+; *(int64_t *) &bb->buffer[idx] = prev = src[0]; idx += 8;
+      mov       r12, QWORD [rsi]
+      mov       rax, QWORD [rdi + bytebuffer.buffer]
+      mov       QWORD [rax + rbx], r12
+      add       rbx, 8
+      lea       r14, [rsi + 8]
+      lea       r13, [rdx - 1]
+.next_block:
+      test      r13, r13
+      jz        .done
+; n = min(remaining, BB_DELTA_BLOCK);
+      mov       rdx, BB_DELTA_BLOCK
+      cmp       r13, rdx
+      cmovb     rdx, r13
+      mov       QWORD [rbp - STACK_BLOCK - 8], rdx
+; for (j = 0; j < n; ++j) { d[j] = src[j] - prev; prev = src[j]; }
+; r8 = min(d), r9 = max(d)
+      lea       rdi, [rbp - STACK_BLOCK]
+      mov       r8, 0x7FFFFFFFFFFFFFFF
+      mov       r9, 0x8000000000000000
+      xor       r10, r10
+.delta:
+      mov       rax, QWORD [r14 + r10 * 8]
+      mov       r11, rax
+      sub       rax, r12
+      mov       r12, r11
+      mov       QWORD [rdi + r10 * 8], rax
+      cmp       rax, r8
+      cmovl     r8, rax
+      cmp       rax, r9
+      cmovg     r9, rax
+      inc       r10
+      cmp       r10, rdx
+      jb        .delta
+; w = (max - min) ? bsr(max - min) + 1 : 0;
+      xor       ecx, ecx
+      mov       rax, r9
+      sub       rax, r8
+      jz        .have_width
+      bsr       rcx, rax
+      inc       rcx
+.have_width:
+; payload = (n * w + 7) / 8;
+      mov       rax, rdx
+      imul      rax, rcx
+      add       rax, 7
+      shr       rax, 3
+; if (idx + 9 + payload > bb->bound) return;
+      lea       r10, [rbx + rax + 9]
+      cmp       r10, QWORD [r15 + bytebuffer.bound]
+      ja        .epilogue
+; *(int64_t *) &bb->buffer[idx] = min; bb->buffer[idx + 8] = w;
+      mov       r11, QWORD [r15 + bytebuffer.buffer]
+      add       r11, rbx
+      mov       QWORD [r11], r8
+      mov       BYTE [r11 + 8], cl
+      mov       rbx, r10
+; for (j = 0; j < n; ++j) d[j] -= min;
+      xor       r10, r10
+.rebase:
+      sub       QWORD [rdi + r10 * 8], r8
+      inc       r10
+      cmp       r10, rdx
+      jb        .rebase
+; pack64(d, n, w, &bb->buffer[idx + 9]);
+      mov       rsi, rdi
+      lea       rdi, [r11 + 9]
+      call      pack64
+; src += n; remaining -= n;
+      mov       rdx, QWORD [rbp - STACK_BLOCK - 8]
+      lea       r14, [r14 + rdx * 8]
+      sub       r13, rdx
+      jmp       .next_block
+.done:
+; bb->index = idx;
+      mov       QWORD [r15 + bytebuffer.index], rbx
+.epilogue:
+      pop       r15
+      pop       r14
+      pop       r13
+      pop       r12
+      pop       rbx
+      mov       rsp, rbp
+      pop       rbp
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an int64_t array of frame of reference delta blocks from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_int64_for_array (bytebuffer_t *bb, int64_t *dst,
+;                                size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = dst
+;   rdx = count
+;
+; stack:
+;
+;   QWORD [rbp - 8]   = rdi (bb)
+;   QWORD [rbp - 16]  = rsi (dst)
+;   QWORD [rbp - 24]  = rdx (count)
+;
+; NOTE: bb->index is unchanged if the data ends (or is malformed) before
+;       count values are decoded.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_int64_for_array:function
+bb_get_int64_for_array:
+      push      rbp
+      mov       rbp, rsp
+      sub       rsp, 24
+      push      rbx
+      push      r12
+      push      r13
+      push      r14
+      push      r15
+      mov       QWORD [rbp - 8], rdi
+      mov       QWORD [rbp - 16], rsi
+      mov       QWORD [rbp - 24], rdx
+; if (count == 0) return;
+      test      rdx, rdx
+      jz        .epilogue
+; if (bb->index + 8 > bb->bound) return;
+      mov       r15, QWORD [rdi + bytebuffer.index]
+      lea       rax, [r15 + 8]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .epilogue
+; r15 = working index, r14 = dst cursor, r13 = remaining
+; dst[0] = *(int64_t *) &bb->buffer[idx]; idx += 8;
+      mov       rax, QWORD [rdi + bytebuffer.buffer]
+      mov       rax, QWORD [rax + r15]
+      mov       QWORD [rsi], rax
+      add       r15, 8
+      lea       r14, [rsi + 8]
+      lea       r13, [rdx - 1]
+.next_block:
+      test      r13, r13
+      jz        .done
+; n = min(remaining, BB_DELTA_BLOCK);
+      mov       rdx, BB_DELTA_BLOCK
+      cmp       r13, rdx
+      cmovb     rdx, r13
+; if (idx + 9 > bb->bound) return;
+      mov       rdi, QWORD [rbp - 8]
+      lea       rax, [r15 + 9]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .epilogue
+; min = *(int64_t *) &bb->buffer[idx]; w = bb->buffer[idx + 8];
+      mov       rsi, QWORD [rdi + bytebuffer.buffer]
+      add       rsi, r15
+      mov       rax, QWORD [rsi]
+      movq      xmm4, rax
+      movzx     ecx, BYTE [rsi + 8]
+      add       rsi, 9
+; if (w > 64) return;
+      cmp       rcx, 64
+      ja        .epilogue
+; payload = (n * w + 7) / 8; if (idx + 9 + payload > bb->bound) return;
+      mov       rax, rdx
+      imul      rax, rcx
+      add       rax, 7
+      shr       rax, 3
+      lea       r10, [rsi + rax]
+      lea       r15, [r15 + rax + 9]
+      cmp       r15, QWORD [rdi + bytebuffer.bound]
+      ja        .epilogue
+; unpack64(dst, n, w, &bb->buffer[idx + 9], end);
+      mov       rdi, r14
+      push      rdx
+      push      rdx
+      call      unpack64
+      pop       rdx
+      pop       rdx
+; for (j = 0; j < n; ++j) dst[j] += min;
+      punpcklqdq xmm4, xmm4
+      mov       rax, r14
+      mov       rcx, rdx
+.rebase_pair:
+      cmp       rcx, 2
+      jb        .rebase_tail
+      movdqu    xmm0, [rax]
+      paddq     xmm0, xmm4
+      movdqu    [rax], xmm0
+      add       rax, 16
+      sub       rcx, 2
+      jmp       .rebase_pair
+.rebase_tail:
+      test      rcx, rcx
+      jz        .rebased
+      movq      r8, xmm4
+      add       QWORD [rax], r8
+.rebased:
+; dst += n; remaining -= n;
+      lea       r14, [r14 + rdx * 8]
+      sub       r13, rdx
+      jmp       .next_block
+.done:
+; bb->index = idx;
+      mov       rdi, QWORD [rbp - 8]
+      mov       QWORD [rdi + bytebuffer.index], r15
+; prefix_sum64(dst, count);
+      mov       rdi, QWORD [rbp - 16]
+      mov       rsi, QWORD [rbp - 24]
+      call      prefix_sum64
+.epilogue:
+      pop       r15
+      pop       r14
+      pop       r13
+      pop       r12
+      pop       rbx
+      mov       rsp, rbp
+      pop       rbp
+      ret
+%endif
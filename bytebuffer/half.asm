@@ -0,0 +1,748 @@
+;-------------------------------------------------------------------------------
+;   ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+;
+;   Copyright (C) 2025  J. McIntosh
+;
+;   This program is free software; you can redistribute it and/or modify
+;   it under the terms of the GNU General Public License as published by
+;   the Free Software Foundation; either version 2 of the License, or
+;   (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License along
+;   with this program; if not, write to the Free Software Foundation, Inc.,
+;   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;-------------------------------------------------------------------------------
+%ifndef HALF_ASM
+%define HALF_ASM  1
+;
+; IEEE 754 binary16 (half) and bfloat16 encoding of float values.  Both are
+; stored as 2 little endian bytes.  Conversions from float round to nearest
+; even.  Half conversions use F16C when the CPU (and OS) support it.
+;
+F16C_UNKNOWN  EQU     0
+F16C_NO       EQU     1
+F16C_YES      EQU     2
+;
+CPUID_F16C    EQU     ((1 << 27) | (1 << 28) | (1 << 29)) ; OSXSAVE|AVX|F16C
+XCR0_AVX      EQU     0x06                                ; XMM|YMM state
+;
+;-------------------------------------------------------------------------------
+;
+%macro BF16_FROM_FLOAT_X4 1
+      movdqa    xmm2, %1
+      psrld     xmm2, 16
+      pand      xmm2, [rel BF16_LSB]
+      paddd     xmm2, [rel BF16_BIAS]
+      paddd     xmm2, %1
+      movdqa    xmm3, %1
+      pand      xmm3, [rel F32_ABS_MASK]
+      pcmpgtd   xmm3, [rel F32_INF]
+      por       %1, [rel F32_QNAN_BIT]
+      pand      %1, xmm3
+      pandn     xmm3, xmm2
+      por       %1, xmm3
+      psrad     %1, 16
+%endmacro
+;
+; Convert 4 floats in register (%1) to bfloat16 in the upper halves of its
+; dwords (sign extended so packssdw keeps the bits).  xmm2, xmm3 are used.
+;-------------------------------------------------------------------------------
+;
+%include "bytebuffer.inc"
+;
+section .rodata
+      align 16
+BF16_LSB:       dd      1, 1, 1, 1
+BF16_BIAS:      dd      0x7FFF, 0x7FFF, 0x7FFF, 0x7FFF
+F32_ABS_MASK:   dd      0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF
+F32_INF:        dd      0x7F800000, 0x7F800000, 0x7F800000, 0x7F800000
+F32_QNAN_BIT:   dd      0x00400000, 0x00400000, 0x00400000, 0x00400000
+F32_TWO_M24:    dd      0x33800000
+;
+section .data
+f16c_state:     dd      F16C_UNKNOWN
+;
+section .text
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Does the CPU support F16C (checked once)
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; return:
+;
+;   eax = 0 (false) | 1 (true)
+;
+; NOTE: Only rax is modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+have_f16c:
+      mov       eax, DWORD [rel f16c_state]
+      test      eax, eax
+      jnz       .known
+      push      rbx
+      push      rcx
+      push      rdx
+      mov       eax, 1
+      cpuid
+      mov       eax, F16C_NO
+      and       ecx, CPUID_F16C
+      cmp       ecx, CPUID_F16C
+      jne       .store
+      xor       ecx, ecx
+      xgetbv
+      and       eax, XCR0_AVX
+      cmp       eax, XCR0_AVX
+      mov       eax, F16C_NO
+      jne       .store
+      mov       eax, F16C_YES
+.store:
+      mov       DWORD [rel f16c_state], eax
+      pop       rdx
+      pop       rcx
+      pop       rbx
+.known:
+      dec       eax
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Convert float to half
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   xmm0 = float value
+;
+; return:
+;
+;   ax = half value
+;
+; NOTE: rax, rcx, rdx, r8, r9, xmm1 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+half_from_float:
+      call      have_f16c
+      test      eax, eax
+      jz        .soft
+      vcvtps2ph xmm1, xmm0, 0
+      vmovd     eax, xmm1
+      ret
+.soft:
+; sign = (x >> 16) & 0x8000; x &= 0x7FFFFFFF;
+      movd      eax, xmm0
+      mov       edx, eax
+      shr       edx, 16
+      and       edx, 0x8000
+      and       eax, 0x7FFFFFFF
+; if (x >= inf) goto inf_nan;
+      cmp       eax, 0x7F800000
+      jae       .inf_nan
+; if (x >= 65520.0f) goto overflow;     (rounds to inf)
+      cmp       eax, 0x477FF000
+      jae       .overflow
+; if (x < 2^-14) goto subnormal;
+      cmp       eax, 0x38800000
+      jb        .subnormal
+; x -= (127 - 15) << 23; h = (x + 0xFFF + ((x >> 13) & 1)) >> 13;
+      sub       eax, 0x38000000
+      mov       ecx, eax
+      shr       ecx, 13
+      and       ecx, 1
+      lea       eax, [rax + rcx + 0xFFF]
+      shr       eax, 13
+      jmp       .sign
+.subnormal:
+; if (x <= 2^-25) goto zero;            (ties to even zero)
+      cmp       eax, 0x33000000
+      jbe       .zero
+; shift = 126 - (x >> 23); m = (x & 0x7FFFFF) | 0x800000;
+      mov       ecx, eax
+      shr       ecx, 23
+      neg       ecx
+      add       ecx, 126
+      and       eax, 0x7FFFFF
+      or        eax, 0x800000
+; h = (m + (1 << (shift - 1)) - 1 + ((m >> shift) & 1)) >> shift;
+      mov       r8d, eax
+      shr       r8d, cl
+      and       r8d, 1
+      add       eax, r8d
+      dec       ecx
+      mov       r9d, 1
+      shl       r9d, cl
+      inc       ecx
+      lea       eax, [rax + r9 - 1]
+      shr       eax, cl
+      jmp       .sign
+.zero:
+      xor       eax, eax
+      jmp       .sign
+.overflow:
+      mov       eax, 0x7C00
+      jmp       .sign
+.inf_nan:
+; h = (x == inf) ? 0x7C00 : 0x7E00 | (x >> 13);     (quiet NaN, keep payload)
+      cmp       eax, 0x7F800000
+      mov       eax, 0x7C00
+      je        .sign
+      movd      eax, xmm0
+      shr       eax, 13
+      and       eax, 0x3FF
+      or        eax, 0x7E00
+.sign:
+      or        eax, edx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Convert half to float
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   eax = half value (zero extended)
+;
+; return:
+;
+;   xmm0 = float value
+;
+; NOTE: rax, rcx, rdx are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+float_from_half:
+      mov       edx, eax
+      call      have_f16c
+      test      eax, eax
+      jz        .soft
+      vmovd     xmm0, edx
+      vcvtph2ps xmm0, xmm0
+      ret
+.soft:
+; sign = (h & 0x8000) << 16; e = (h >> 10) & 0x1F; m = h & 0x3FF;
+      mov       eax, edx
+      mov       ecx, edx
+      and       edx, 0x8000
+      shl       edx, 16
+      shr       ecx, 10
+      and       ecx, 0x1F
+      and       eax, 0x3FF
+      cmp       ecx, 0x1F
+      je        .inf_nan
+      test      ecx, ecx
+      jz        .subnormal
+; x = ((e + 127 - 15) << 23) | (m << 13);
+      add       ecx, 112
+      shl       ecx, 23
+      shl       eax, 13
+      or        eax, ecx
+      jmp       .sign
+.inf_nan:
+; x = 0x7F800000 | (m << 13) | (m ? 0x400000 : 0);     (quiet NaN)
+      shl       eax, 13
+      jz        .inf
+      or        eax, 0x00400000
+.inf:
+      or        eax, 0x7F800000
+      jmp       .sign
+.subnormal:
+; x = (float) m * 2^-24;                (exact, m == 0 gives 0)
+      cvtsi2ss  xmm0, eax
+      mulss     xmm0, DWORD [rel F32_TWO_M24]
+      movd      eax, xmm0
+.sign:
+      or        eax, edx
+      movd      xmm0, eax
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Convert float to bfloat16
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   xmm0 = float value
+;
+; return:
+;
+;   ax = bfloat16 value
+;
+; NOTE: rax, rcx are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+bf16_from_float:
+      movd      eax, xmm0
+; if ((x & 0x7FFFFFFF) > inf) return (x >> 16) | 0x40;
+      mov       ecx, eax
+      and       ecx, 0x7FFFFFFF
+      cmp       ecx, 0x7F800000
+      ja        .nan
+; return (x + 0x7FFF + ((x >> 16) & 1)) >> 16;
+      mov       ecx, eax
+      shr       ecx, 16
+      and       ecx, 1
+      lea       eax, [rax + rcx + 0x7FFF]
+      shr       eax, 16
+      ret
+.nan:
+      shr       eax, 16
+      or        eax, 0x40
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put half value in bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_half (bytebuffer_t *bb, float value);
+;
+; param:
+;
+;   rdi   = bb
+;   xmm0  = value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_half:function
+bb_put_half:
+; if (bb->index + 2 > bb->bound) return;
+      mov       rsi, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; *(uint16_t *) &bb->buffer[bb->index] = half(value);
+      call      half_from_float
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      mov       WORD [rsi], ax
+; bb->index += 2;
+      add       QWORD [rdi + bytebuffer.index], 2
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put half value in bytebuffer at index
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_half_at (bytebuffer_t *bb, size_t index, float value);
+;
+; param:
+;
+;   rdi   = bb
+;   rsi   = index
+;   xmm0  = value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_half_at:function
+bb_put_half_at:
+; if (index + 2 > bb->bound) return;
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; *(uint16_t *) &bb->buffer[index] = half(value);
+      call      half_from_float
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      mov       WORD [rsi], ax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get a half value from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   float bb_get_half (bytebuffer_t *bb);
+;
+; param:
+;
+;   rdi = bb
+;
+; return:
+;
+;   xmm0 = float value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_half:function
+bb_get_half:
+; if (bb->index + 2 > bb->bound) return 0;
+      xorps     xmm0, xmm0
+      mov       rsi, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; bb->index += 2;
+      mov       QWORD [rdi + bytebuffer.index], rax
+; return float(*(uint16_t *) &bb->buffer[index]);
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      movzx     eax, WORD [rsi]
+      call      float_from_half
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get a half value at index from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   float bb_get_half_at (bytebuffer_t *bb, size_t index);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = index
+;
+; return:
+;
+;   xmm0 = float value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_half_at:function
+bb_get_half_at:
+; if (index + 2 > bb->bound) return 0;
+      xorps     xmm0, xmm0
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; return float(*(uint16_t *) &bb->buffer[index]);
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      movzx     eax, WORD [rsi]
+      call      float_from_half
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put bfloat16 value in bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bf16 (bytebuffer_t *bb, float value);
+;
+; param:
+;
+;   rdi   = bb
+;   xmm0  = value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bf16:function
+bb_put_bf16:
+; if (bb->index + 2 > bb->bound) return;
+      mov       rsi, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; *(uint16_t *) &bb->buffer[bb->index] = bf16(value);
+      call      bf16_from_float
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      mov       WORD [rsi], ax
+; bb->index += 2;
+      add       QWORD [rdi + bytebuffer.index], 2
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put bfloat16 value in bytebuffer at index
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bf16_at (bytebuffer_t *bb, size_t index, float value);
+;
+; param:
+;
+;   rdi   = bb
+;   rsi   = index
+;   xmm0  = value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bf16_at:function
+bb_put_bf16_at:
+; if (index + 2 > bb->bound) return;
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; *(uint16_t *) &bb->buffer[index] = bf16(value);
+      call      bf16_from_float
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      mov       WORD [rsi], ax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get a bfloat16 value from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   float bb_get_bf16 (bytebuffer_t *bb);
+;
+; param:
+;
+;   rdi = bb
+;
+; return:
+;
+;   xmm0 = float value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bf16:function
+bb_get_bf16:
+; if (bb->index + 2 > bb->bound) return 0;
+      xorps     xmm0, xmm0
+      mov       rsi, QWORD [rdi + bytebuffer.index]
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; bb->index += 2;
+      mov       QWORD [rdi + bytebuffer.index], rax
+; return float(*(uint16_t *) &bb->buffer[index] << 16);
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      movzx     eax, WORD [rsi]
+      shl       eax, 16
+      movd      xmm0, eax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get a bfloat16 value at index from bytebuffer
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   float bb_get_bf16_at (bytebuffer_t *bb, size_t index);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = index
+;
+; return:
+;
+;   xmm0 = float value
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bf16_at:function
+bb_get_bf16_at:
+; if (index + 2 > bb->bound) return 0;
+      xorps     xmm0, xmm0
+      lea       rax, [rsi + 2]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; return float(*(uint16_t *) &bb->buffer[index] << 16);
+      add       rsi, QWORD [rdi + bytebuffer.buffer]
+      movzx     eax, WORD [rsi]
+      shl       eax, 16
+      movd      xmm0, eax
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an array of floats in bytebuffer as half values
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_half_array (bytebuffer_t *bb, float const *src, size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = src
+;   rdx = count
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_half_array:function
+bb_put_half_array:
+      push      rbx
+; if (bb->index + count * 2 > bb->bound) return;
+      lea       rax, [rdx * 2]
+      add       rax, QWORD [rdi + bytebuffer.index]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; byte_t *wp = &bb->buffer[bb->index]; bb->index += count * 2;
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, QWORD [rdi + bytebuffer.index]
+      mov       QWORD [rdi + bytebuffer.index], rax
+      mov       rbx, rdx
+      call      have_f16c
+      test      eax, eax
+      jz        .scalar
+.vector:
+; convert 8 floats per pass
+      cmp       rbx, 8
+      jb        .vector_done
+      vmovups   ymm0, [rsi]
+      vcvtps2ph [r10], ymm0, 0
+      add       rsi, 32
+      add       r10, 16
+      sub       rbx, 8
+      jmp       .vector
+.vector_done:
+      vzeroupper
+.scalar:
+      test      rbx, rbx
+      jz        .return
+      movss     xmm0, DWORD [rsi]
+      call      half_from_float
+      mov       WORD [r10], ax
+      add       rsi, 4
+      add       r10, 2
+      dec       rbx
+      jmp       .scalar
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an array of half values from bytebuffer as floats
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_half_array (bytebuffer_t *bb, float *dst, size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = dst
+;   rdx = count
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_half_array:function
+bb_get_half_array:
+      push      rbx
+; if (bb->index + count * 2 > bb->bound) return;
+      lea       rax, [rdx * 2]
+      add       rax, QWORD [rdi + bytebuffer.index]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; byte_t *rp = &bb->buffer[bb->index]; bb->index += count * 2;
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, QWORD [rdi + bytebuffer.index]
+      mov       QWORD [rdi + bytebuffer.index], rax
+      mov       rbx, rdx
+      call      have_f16c
+      test      eax, eax
+      jz        .scalar
+.vector:
+; convert 8 halves per pass
+      cmp       rbx, 8
+      jb        .vector_done
+      vcvtph2ps ymm0, [r10]
+      vmovups   [rsi], ymm0
+      add       r10, 16
+      add       rsi, 32
+      sub       rbx, 8
+      jmp       .vector
+.vector_done:
+      vzeroupper
+.scalar:
+      test      rbx, rbx
+      jz        .return
+      movzx     eax, WORD [r10]
+      call      float_from_half
+      movss     DWORD [rsi], xmm0
+      add       r10, 2
+      add       rsi, 4
+      dec       rbx
+      jmp       .scalar
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an array of floats in bytebuffer as bfloat16 values
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_bf16_array (bytebuffer_t *bb, float const *src, size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = src
+;   rdx = count
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_bf16_array:function
+bb_put_bf16_array:
+; if (bb->index + count * 2 > bb->bound) return;
+      lea       rax, [rdx * 2]
+      add       rax, QWORD [rdi + bytebuffer.index]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; byte_t *wp = &bb->buffer[bb->index]; bb->index += count * 2;
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, QWORD [rdi + bytebuffer.index]
+      mov       QWORD [rdi + bytebuffer.index], rax
+.vector:
+; convert 8 floats per pass (SSE2)
+      cmp       rdx, 8
+      jb        .scalar
+      movdqu    xmm0, [rsi]
+      movdqu    xmm1, [rsi + 16]
+      BF16_FROM_FLOAT_X4 xmm0
+      BF16_FROM_FLOAT_X4 xmm1
+      packssdw  xmm0, xmm1
+      movdqu    [r10], xmm0
+      add       rsi, 32
+      add       r10, 16
+      sub       rdx, 8
+      jmp       .vector
+.scalar:
+      test      rdx, rdx
+      jz        .return
+      movss     xmm0, DWORD [rsi]
+      call      bf16_from_float
+      mov       WORD [r10], ax
+      add       rsi, 4
+      add       r10, 2
+      dec       rdx
+      jmp       .scalar
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an array of bfloat16 values from bytebuffer as floats
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_bf16_array (bytebuffer_t *bb, float *dst, size_t count);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = dst
+;   rdx = count
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_bf16_array:function
+bb_get_bf16_array:
+; if (bb->index + count * 2 > bb->bound) return;
+      lea       rax, [rdx * 2]
+      add       rax, QWORD [rdi + bytebuffer.index]
+      cmp       rax, QWORD [rdi + bytebuffer.bound]
+      ja        .return
+; byte_t *rp = &bb->buffer[bb->index]; bb->index += count * 2;
+      mov       r10, QWORD [rdi + bytebuffer.buffer]
+      add       r10, QWORD [rdi + bytebuffer.index]
+      mov       QWORD [rdi + bytebuffer.index], rax
+.vector:
+; widen 8 values per pass (SSE2): float bits = bf16 << 16
+      cmp       rdx, 8
+      jb        .scalar
+      movdqu    xmm1, [r10]
+      pxor      xmm0, xmm0
+      pxor      xmm2, xmm2
+      punpcklwd xmm0, xmm1
+      punpckhwd xmm2, xmm1
+      movdqu    [rsi], xmm0
+      movdqu    [rsi + 16], xmm2
+      add       r10, 16
+      add       rsi, 32
+      sub       rdx, 8
+      jmp       .vector
+.scalar:
+      test      rdx, rdx
+      jz        .return
+      movzx     eax, WORD [r10]
+      shl       eax, 16
+      mov       DWORD [rsi], eax
+      add       r10, 2
+      add       rsi, 4
+      dec       rdx
+      jmp       .scalar
+.return:
+      ret
+%endif
@@ -0,0 +1,227 @@
+;-------------------------------------------------------------------------------
+;   ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+;
+;   Copyright (C) 2025  J. McIntosh
+;
+;   This program is free software; you can redistribute it and/or modify
+;   it under the terms of the GNU General Public License as published by
+;   the Free Software Foundation; either version 2 of the License, or
+;   (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License along
+;   with this program; if not, write to the Free Software Foundation, Inc.,
+;   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;-------------------------------------------------------------------------------
+%ifndef RECORD_ASM
+%define RECORD_ASM  1
+;
+; A record is a uint32_t length (little endian) followed by that many bytes.
+; bb_build_index records the offset of each length prefix so that record n
+; is reached in O(1) and records can be decoded out of order (see
+; bb_decode_parallel in bytebuffer.c).
+;
+extern free
+extern realloc
+;
+%include "bytebuffer.inc"
+;
+BB_INDEX_MIN_CAPACITY   EQU     1024
+;
+section .text
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Build an index of the records between bb->index and bb->bound
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   ssize_t bb_build_index (bytebuffer_t *bb, bb_index_t *idx);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = idx (zeroed, or built before: its offset array is reused)
+;
+; stack:
+;
+;   QWORD [rbp - 8]   = cap (new capacity while growing)
+;   QWORD [rbp - 16]  = end (saved across realloc)
+;   QWORD [rbp - 24]  = count (saved across realloc)
+;
+; return:
+;
+;   rax = number of records indexed | -1 (realloc failed)
+;
+; NOTE: The walk stops at a record whose length runs past the bound, so a
+;       truncated tail is not indexed.  bb->index is not changed.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_build_index:function
+bb_build_index:
+      push      rbp
+      mov       rbp, rsp
+      sub       rsp, 24
+      push      rbx
+      push      r12
+      push      r13
+      push      r14
+      push      r15
+; r12 = buffer, r13 = off, r14 = bound, r15 = idx, rbx = count,
+; r10 = idx->offset
+      mov       r12, QWORD [rdi + bytebuffer.buffer]
+      mov       r13, QWORD [rdi + bytebuffer.index]
+      mov       r14, QWORD [rdi + bytebuffer.bound]
+      mov       r15, rsi
+      xor       rbx, rbx
+      mov       r10, QWORD [r15 + bb_index.offset]
+.next_record:
+; if (off + BB_RECORD_HEADER > bound) break;
+      lea       rax, [r13 + BB_RECORD_HEADER]
+      cmp       rax, r14
+      ja        .done
+; end = off + BB_RECORD_HEADER + *(uint32_t *) &buffer[off];
+      mov       ecx, DWORD [r12 + r13]
+      add       rcx, rax
+; if (end > bound) break;
+      cmp       rcx, r14
+      ja        .done
+; if (count == idx->capacity) grow;
+      cmp       rbx, QWORD [r15 + bb_index.capacity]
+      jae       .grow
+.store:
+; idx->offset[count++] = off; off = end;
+      mov       QWORD [r10 + rbx * 8], r13
+      inc       rbx
+      mov       r13, rcx
+      jmp       .next_record
+.grow:
+      mov       QWORD [rbp - 16], rcx
+      mov       QWORD [rbp - 24], rbx
+; cap = idx->capacity ? idx->capacity * 2 : BB_INDEX_MIN_CAPACITY;
+      mov       rsi, QWORD [r15 + bb_index.capacity]
+      add       rsi, rsi
+      mov       rax, BB_INDEX_MIN_CAPACITY
+      test      rsi, rsi
+      cmovz     rsi, rax
+      mov       QWORD [rbp - 8], rsi
+; if ((p = realloc(idx->offset, cap * sizeof(size_t))) == NULL) goto failure;
+      mov       rdi, r10
+      shl       rsi, 3
+      ALIGN_STACK_AND_CALL rbx, realloc, wrt, ..plt
+      mov       rbx, QWORD [rbp - 24]
+      mov       rcx, QWORD [rbp - 16]
+      test      rax, rax
+      jz        .failure
+; idx->offset = p; idx->capacity = cap;
+      mov       QWORD [r15 + bb_index.offset], rax
+      mov       r10, rax
+      mov       rax, QWORD [rbp - 8]
+      mov       QWORD [r15 + bb_index.capacity], rax
+      jmp       .store
+.failure:
+; idx->count = count; return -1;
+      mov       QWORD [r15 + bb_index.count], rbx
+      mov       rax, -1
+      jmp       .epilogue
+.done:
+; idx->count = count; return count;
+      mov       QWORD [r15 + bb_index.count], rbx
+      mov       rax, rbx
+.epilogue:
+      pop       r15
+      pop       r14
+      pop       r13
+      pop       r12
+      pop       rbx
+      mov       rsp, rbp
+      pop       rbp
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Release the offset array of a record index
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_index_term (bb_index_t *idx);
+;
+; param:
+;
+;   rdi = idx
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_index_term:function
+bb_index_term:
+      push      rbx
+      push      r12
+      mov       r12, rdi
+; free(idx->offset);
+      mov       rdi, QWORD [rdi + bb_index.offset]
+      ALIGN_STACK_AND_CALL rbx, free, wrt, ..plt
+; idx->offset = NULL; idx->count = 0; idx->capacity = 0;
+      xor       rax, rax
+      mov       QWORD [r12 + bb_index.offset], rax
+      mov       QWORD [r12 + bb_index.count], rax
+      mov       QWORD [r12 + bb_index.capacity], rax
+      pop       r12
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Point a read cursor at record n
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   int bb_record_at (bytebuffer_t *bb, bb_index_t *idx, size_t n,
+;                     bytebuffer_t *view);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = idx
+;   rdx = n
+;   rcx = view
+;
+; return:
+;
+;   eax = 1 (success) | -1 (n out of range)
+;
+; NOTE: view becomes a bytebuffer over the record payload (index 0, bound
+;       and size = record length) that shares bb's storage.  It can be read
+;       with the bb_get_* functions from any thread while bb is not written;
+;       bb_term on a view does not release anything.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_record_at:function
+bb_record_at:
+; if (n >= idx->count) return -1;
+      cmp       rdx, QWORD [rsi + bb_index.count]
+      jae       .failure
+; p = &bb->buffer[idx->offset[n]]; len = *(uint32_t *) p;
+      mov       rax, QWORD [rsi + bb_index.offset]
+      mov       rax, QWORD [rax + rdx * 8]
+      add       rax, QWORD [rdi + bytebuffer.buffer]
+      mov       r8d, DWORD [rax]
+      add       rax, BB_RECORD_HEADER
+; view->buffer = p + BB_RECORD_HEADER; view->bound = view->size = len;
+      mov       QWORD [rcx + bytebuffer.buffer], rax
+      mov       QWORD [rcx + bytebuffer.bound], r8
+      mov       QWORD [rcx + bytebuffer.size], r8
+; view->index = 0; view->mark = -1; view->map_size = BB_MAP_VIEW;
+      xor       eax, eax
+      mov       QWORD [rcx + bytebuffer.index], rax
+      mov       QWORD [rcx + bytebuffer.mark], -1
+      mov       QWORD [rcx + bytebuffer.map_size], BB_MAP_VIEW
+; view->bit_acc = 0; view->bit_count = 0;
+      mov       QWORD [rcx + bytebuffer.bit_acc], rax
+      mov       QWORD [rcx + bytebuffer.bit_count], rax
+; return 1;
+      mov       eax, 1
+      ret
+.failure:
+      mov       eax, -1
+      ret
+%endif
@@ -0,0 +1,456 @@
+;-------------------------------------------------------------------------------
+;   ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+;
+;   Copyright (C) 2025  J. McIntosh
+;
+;   This program is free software; you can redistribute it and/or modify
+;   it under the terms of the GNU General Public License as published by
+;   the Free Software Foundation; either version 2 of the License, or
+;   (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License along
+;   with this program; if not, write to the Free Software Foundation, Inc.,
+;   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;-------------------------------------------------------------------------------
+%ifndef SOA_ASM
+%define SOA_ASM  1
+;
+; An array of structs (rows of stride bytes) is written field by field: all
+; count values of the first field of the layout, then all of the second, and
+; so on (struct of arrays).  Values are copied as they are in memory.
+;
+; Rows are processed in tiles of about BB_SOA_TILE_BYTES so that a tile stays
+; in cache while each of its fields is copied in turn.  4 and 8 byte fields
+; are moved through SSE2 registers 4 / 2 rows at a time.
+;
+%include "bytebuffer.inc"
+;
+BB_SOA_TILE_BYTES   EQU     0x4000
+BB_SOA_TILE_MIN     EQU     16
+;
+section .text
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Gather one field of n rows into a column
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdi = column
+;   rsi = field of first row
+;   rdx = n
+;   rcx = stride
+;   r8  = field size
+;
+; NOTE: rax, rdx, rsi, rdi, r9, r10, xmm0 - xmm3 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+soa_gather:
+      cmp       r8, 8
+      je        .qword
+      cmp       r8, 4
+      je        .dword
+      cmp       r8, 2
+      je        .word
+      cmp       r8, 1
+      je        .byte
+.any:
+; for (; n > 0; --n, row += stride) copy size bytes;
+      xor       r9, r9
+.any_byte:
+      mov       al, BYTE [rsi + r9]
+      mov       BYTE [rdi], al
+      inc       rdi
+      inc       r9
+      cmp       r9, r8
+      jb        .any_byte
+      add       rsi, rcx
+      dec       rdx
+      jnz       .any
+      ret
+.qword:
+      cmp       rdx, 2
+      jb        .qword_tail
+; column[0..1] = row[0], row[1]
+      movq      xmm0, QWORD [rsi]
+      movhps    xmm0, QWORD [rsi + rcx]
+      movdqu    [rdi], xmm0
+      lea       rsi, [rsi + rcx * 2]
+      add       rdi, 16
+      sub       rdx, 2
+      jmp       .qword
+.qword_tail:
+      test      rdx, rdx
+      jz        .return
+      mov       rax, QWORD [rsi]
+      mov       QWORD [rdi], rax
+      ret
+.dword:
+      cmp       rdx, 4
+      jb        .dword_tail
+; column[0..3] = row[0], row[1], row[2], row[3]
+      lea       r10, [rsi + rcx * 2]
+      movd      xmm0, DWORD [rsi]
+      movd      xmm1, DWORD [rsi + rcx]
+      movd      xmm2, DWORD [r10]
+      movd      xmm3, DWORD [r10 + rcx]
+      punpckldq xmm0, xmm1
+      punpckldq xmm2, xmm3
+      punpcklqdq xmm0, xmm2
+      movdqu    [rdi], xmm0
+      lea       rsi, [r10 + rcx * 2]
+      add       rdi, 16
+      sub       rdx, 4
+      jmp       .dword
+.dword_tail:
+      test      rdx, rdx
+      jz        .return
+      mov       eax, DWORD [rsi]
+      mov       DWORD [rdi], eax
+      add       rsi, rcx
+      add       rdi, 4
+      dec       rdx
+      jmp       .dword_tail
+.word:
+      mov       ax, WORD [rsi]
+      mov       WORD [rdi], ax
+      add       rsi, rcx
+      add       rdi, 2
+      dec       rdx
+      jnz       .word
+      ret
+.byte:
+      mov       al, BYTE [rsi]
+      mov       BYTE [rdi], al
+      add       rsi, rcx
+      inc       rdi
+      dec       rdx
+      jnz       .byte
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Scatter a column into one field of n rows
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdi = column
+;   rsi = field of first row
+;   rdx = n
+;   rcx = stride
+;   r8  = field size
+;
+; NOTE: rax, rdx, rsi, rdi, r9, r10, xmm0 - xmm3 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+soa_scatter:
+      cmp       r8, 8
+      je        .qword
+      cmp       r8, 4
+      je        .dword
+      cmp       r8, 2
+      je        .word
+      cmp       r8, 1
+      je        .byte
+.any:
+      xor       r9, r9
+.any_byte:
+      mov       al, BYTE [rdi]
+      mov       BYTE [rsi + r9], al
+      inc       rdi
+      inc       r9
+      cmp       r9, r8
+      jb        .any_byte
+      add       rsi, rcx
+      dec       rdx
+      jnz       .any
+      ret
+.qword:
+      cmp       rdx, 2
+      jb        .qword_tail
+; row[0], row[1] = column[0..1]
+      movdqu    xmm0, [rdi]
+      movq      QWORD [rsi], xmm0
+      movhps    QWORD [rsi + rcx], xmm0
+      lea       rsi, [rsi + rcx * 2]
+      add       rdi, 16
+      sub       rdx, 2
+      jmp       .qword
+.qword_tail:
+      test      rdx, rdx
+      jz        .return
+      mov       rax, QWORD [rdi]
+      mov       QWORD [rsi], rax
+      ret
+.dword:
+      cmp       rdx, 4
+      jb        .dword_tail
+; row[0], row[1], row[2], row[3] = column[0..3]
+      lea       r10, [rsi + rcx * 2]
+      movdqu    xmm0, [rdi]
+      pshufd    xmm1, xmm0, 0x55
+      pshufd    xmm2, xmm0, 0xAA
+      pshufd    xmm3, xmm0, 0xFF
+      movd      DWORD [rsi], xmm0
+      movd      DWORD [rsi + rcx], xmm1
+      movd      DWORD [r10], xmm2
+      movd      DWORD [r10 + rcx], xmm3
+      lea       rsi, [r10 + rcx * 2]
+      add       rdi, 16
+      sub       rdx, 4
+      jmp       .dword
+.dword_tail:
+      test      rdx, rdx
+      jz        .return
+      mov       eax, DWORD [rdi]
+      mov       DWORD [rsi], eax
+      add       rsi, rcx
+      add       rdi, 4
+      dec       rdx
+      jmp       .dword_tail
+.word:
+      mov       ax, WORD [rdi]
+      mov       WORD [rsi], ax
+      add       rsi, rcx
+      add       rdi, 2
+      dec       rdx
+      jnz       .word
+      ret
+.byte:
+      mov       al, BYTE [rdi]
+      mov       BYTE [rsi], al
+      add       rsi, rcx
+      inc       rdi
+      dec       rdx
+      jnz       .byte
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Size in bytes of count rows of a field layout
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdx = count
+;   r8  = layout
+;
+; return:
+;
+;   rax = count * (sum of field sizes) | -1 (overflow)
+;
+; NOTE: r9, r10 are modified.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+soa_size:
+; for (row = 0, f = layout; f->size != 0; ++f) row += f->size;
+      xor       eax, eax
+      mov       r9, r8
+.next_field:
+      mov       r10d, DWORD [r9 + bb_field.size]
+      test      r10, r10
+      jz        .have_row
+      add       rax, r10
+      add       r9, bb_field_size
+      jmp       .next_field
+.have_row:
+; return count * row;
+      imul      rax, rdx
+      jno       .return
+      mov       rax, -1
+.return:
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Copy every field of count rows between rows and columns, a tile at a time
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; param:
+;
+;   rdi = columns (first byte of the first column)
+;   rsi = base (first row)
+;   rdx = count
+;   rcx = stride
+;   r8  = layout
+;   r9  = soa_gather | soa_scatter
+;
+; stack:
+;
+;   QWORD [rbp - 8]   = rdi (columns)
+;   QWORD [rbp - 16]  = rsi (base)
+;   QWORD [rbp - 24]  = rdx (count)
+;   QWORD [rbp - 32]  = rcx (stride)
+;   QWORD [rbp - 40]  = r8 (layout)
+;   QWORD [rbp - 48]  = r9 (copy)
+;   QWORD [rbp - 56]  = tile (rows per tile)
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+soa_tiles:
+      push      rbp
+      mov       rbp, rsp
+      sub       rsp, 56
+      push      rbx
+      push      r12
+      push      r13
+      push      r14
+      push      r15
+      mov       QWORD [rbp - 8], rdi
+      mov       QWORD [rbp - 16], rsi
+      mov       QWORD [rbp - 24], rdx
+      mov       QWORD [rbp - 32], rcx
+      mov       QWORD [rbp - 40], r8
+      mov       QWORD [rbp - 48], r9
+; tile = stride ? BB_SOA_TILE_BYTES / stride : BB_SOA_TILE_BYTES;
+      mov       rax, BB_SOA_TILE_BYTES
+      test      rcx, rcx
+      jz        .have_tile
+      xor       edx, edx
+      div       rcx
+.have_tile:
+; if (tile < BB_SOA_TILE_MIN) tile = BB_SOA_TILE_MIN;
+      mov       rcx, BB_SOA_TILE_MIN
+      cmp       rax, rcx
+      cmovb     rax, rcx
+      mov       QWORD [rbp - 56], rax
+; r12 = first row of tile, r13 = rows in tile, r14 = field, r15 = column
+      xor       r12, r12
+.next_tile:
+; if (r0 >= count) return;
+      cmp       r12, QWORD [rbp - 24]
+      jae       .epilogue
+; n = min(count - r0, tile);
+      mov       r13, QWORD [rbp - 24]
+      sub       r13, r12
+      cmp       r13, QWORD [rbp - 56]
+      cmova     r13, QWORD [rbp - 56]
+      mov       r14, QWORD [rbp - 40]
+      mov       r15, QWORD [rbp - 8]
+.next_field:
+; if (f->size == 0) next tile;
+      mov       ebx, DWORD [r14 + bb_field.size]
+      test      rbx, rbx
+      jz        .tile_done
+; copy(&column[r0 * size], base + r0 * stride + f->offset, n, stride, size);
+      mov       rdi, r12
+      imul      rdi, rbx
+      add       rdi, r15
+      mov       rsi, r12
+      imul      rsi, QWORD [rbp - 32]
+      add       rsi, QWORD [rbp - 16]
+      mov       eax, DWORD [r14 + bb_field.offset]
+      add       rsi, rax
+      mov       rdx, r13
+      mov       rcx, QWORD [rbp - 32]
+      mov       r8, rbx
+      call      QWORD [rbp - 48]
+; column += count * size; ++f;
+      imul      rbx, QWORD [rbp - 24]
+      add       r15, rbx
+      add       r14, bb_field_size
+      jmp       .next_field
+.tile_done:
+      add       r12, r13
+      jmp       .next_tile
+.epilogue:
+      pop       r15
+      pop       r14
+      pop       r13
+      pop       r12
+      pop       rbx
+      mov       rsp, rbp
+      pop       rbp
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Put an array of structs in bytebuffer one field at a time
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_put_soa (bytebuffer_t *bb, void const *base, size_t count,
+;                    size_t stride, bb_field_t const *layout);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = base
+;   rdx = count
+;   rcx = stride
+;   r8  = layout (terminated by a field of size 0)
+;
+; NOTE: Nothing is written if count rows do not fit before the bound.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_put_soa:function
+bb_put_soa:
+      push      rbx
+      mov       rbx, rdi
+; total = soa_size(count, layout); if (bb->index + total > bb->bound) return;
+      call      soa_size
+      cmp       rax, -1
+      je        .return
+      mov       rdi, QWORD [rbx + bytebuffer.index]
+      add       rdi, rax
+      jc        .return
+      cmp       rdi, QWORD [rbx + bytebuffer.bound]
+      ja        .return
+      push      rdi
+; soa_tiles(&bb->buffer[bb->index], base, count, stride, layout, soa_gather);
+      mov       rdi, QWORD [rbx + bytebuffer.buffer]
+      add       rdi, QWORD [rbx + bytebuffer.index]
+      lea       r9, [rel soa_gather]
+      call      soa_tiles
+; bb->index += total;
+      pop       rdi
+      mov       QWORD [rbx + bytebuffer.index], rdi
+.return:
+      pop       rbx
+      ret
+;
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; Get an array of structs from bytebuffer one field at a time
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+; C definition
+;
+;   void bb_get_aos (bytebuffer_t *bb, void *base, size_t count,
+;                    size_t stride, bb_field_t const *layout);
+;
+; param:
+;
+;   rdi = bb
+;   rsi = base
+;   rdx = count
+;   rcx = stride
+;   r8  = layout (terminated by a field of size 0)
+;
+; NOTE: Nothing is read if count rows are not available before the bound.
+;       Bytes of a row outside the layout's fields are left as they are.
+;- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+;
+      global bb_get_aos:function
+bb_get_aos:
+      push      rbx
+      mov       rbx, rdi
+; total = soa_size(count, layout); if (bb->index + total > bb->bound) return;
+      call      soa_size
+      cmp       rax, -1
+      je        .return
+      mov       rdi, QWORD [rbx + bytebuffer.index]
+      add       rdi, rax
+      jc        .return
+      cmp       rdi, QWORD [rbx + bytebuffer.bound]
+      ja        .return
+      push      rdi
+; soa_tiles(&bb->buffer[bb->index], base, count, stride, layout, soa_scatter);
+      mov       rdi, QWORD [rbx + bytebuffer.buffer]
+      add       rdi, QWORD [rbx + bytebuffer.index]
+      lea       r9, [rel soa_scatter]
+      call      soa_tiles
+; bb->index += total;
+      pop       rdi
+      mov       QWORD [rbx + bytebuffer.index], rdi
+.return:
+      pop       rbx
+      ret
+%endif
@@ -47,6 +47,8 @@ make clean; make
 
 test -e ./demo || exit -1
 
+test -e ./demo_cpp || exit -1
+
 chmod 744 ./go_demo.sh || exit -1
 
 echo -e "${sep}"
@@ -31,3 +31,9 @@ echo -e "\nRunning ./demo"
 
 echo -e "\n${sep}\n"
 
+echo -e "\nRunning ./demo_cpp"
+
+./demo_cpp
+
+echo -e "\n${sep}\n"
+
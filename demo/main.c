@@ -43,6 +43,20 @@ int main (int argc, char **argv)
 
   bb_free(buffer);
 
+  bitValues();
+
+  halfValues();
+
+  deltaValues();
+
+  sboValues();
+
+  recordValues();
+
+  soaValues();
+
+  streamValues();
+
   return 0;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -561,4 +575,346 @@ void putValues (bytebuffer_t *buffer)
     putText(buffer, txt);
   }
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// BITVALUES
+void bitValues (void)
+{
+  bytebuffer_t *buffer = bb_alloc();
+
+  bb_init(buffer, BUFFER_SIZE, NULL);
+
+  uint32_t flags [8] = { 1, 0, 3, 2, 7, 5, 4, 6 };
+
+  bb_put_bits(buffer, 5, 3);
+
+  bb_put_bits(buffer, 1, 1);
+
+  bb_put_bits(buffer, 1000, 10);
+
+  bb_put_bits_array(buffer, flags, 8, 3);
+
+  bb_put_bits_align(buffer);
+
+  printf("bits: 3 + 1 + 10 + 8 x 3 bits in %lu bytes\n",
+      bb_get_index(buffer));
+
+  bb_flip(buffer);
+
+  uint64_t b3 = bb_get_bits(buffer, 3);
+
+  uint64_t b1 = bb_get_bits(buffer, 1);
+
+  uint64_t b10 = bb_get_bits(buffer, 10);
+
+  printf("bits: %lu %lu %lu\n", b3, b1, b10);
+
+  uint32_t out [8];
+
+  bb_get_bits_array(buffer, out, 8, 3);
+
+  bb_get_bits_align(buffer);
+
+  printf("bits array:");
+  for (int i = 0; i < 8; ++i) printf(" %u", out[i]);
+  putchar('\n');
+
+  bb_term(buffer);
+
+  bb_free(buffer);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// HALFVALUES
+void halfValues (void)
+{
+  bytebuffer_t *buffer = bb_alloc();
+
+  bb_init(buffer, BUFFER_SIZE, NULL);
+
+  float weights [4] = { 0.5f, -1.25f, 65504.0f, 3.140625f };
+
+  bb_put_half(buffer, 1.0f);
+
+  bb_put_bf16(buffer, 3.0e38f);
+
+  bb_put_half_array(buffer, weights, 4);
+
+  bb_put_bf16_array(buffer, weights, 4);
+
+  // reserve a half after the arrays, then fill it in place
+
+  size_t index = bb_get_index(buffer);
+
+  bb_put_half(buffer, 0.0f);
+
+  bb_put_half_at(buffer, index, -0.375f);
+
+  bb_flip(buffer);
+
+  printf("half: %f\n", bb_get_half(buffer));
+
+  printf("bf16: %e\n", bb_get_bf16(buffer));
+
+  float out [4];
+
+  bb_get_half_array(buffer, out, 4);
+
+  printf("half array:");
+  for (int i = 0; i < 4; ++i) printf(" %f", out[i]);
+  putchar('\n');
+
+  bb_get_bf16_array(buffer, out, 4);
+
+  printf("bf16 array:");
+  for (int i = 0; i < 4; ++i) printf(" %f", out[i]);
+  putchar('\n');
+
+  printf("half: %f at: %lu\n", bb_get_half_at(buffer, index), index);
+
+  bb_term(buffer);
+
+  bb_free(buffer);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// DELTAVALUES
+void deltaValues (void)
+{
+  bytebuffer_t *buffer = bb_alloc();
+
+  bb_init(buffer, BUFFER_SIZE, NULL);
+
+  int64_t times [8];
+
+  for (int i = 0; i < 8; ++i) times[i] = 1700000000000L + i * 250 - (i & 1);
+
+  bb_put_int64_delta_array(buffer, times, 8);
+
+  size_t index = bb_get_index(buffer);
+
+  printf("delta: 8 x int64_t in %lu bytes\n", index);
+
+  bb_put_int64_for_array(buffer, times, 8);
+
+  printf("for: 8 x int64_t in %lu bytes\n", bb_get_index(buffer) - index);
+
+  bb_flip(buffer);
+
+  int64_t out [8];
+
+  bb_get_int64_delta_array(buffer, out, 8);
+
+  printf("delta:");
+  for (int i = 0; i < 8; ++i) printf(" %ld", out[i]);
+  putchar('\n');
+
+  bb_get_int64_for_array(buffer, out, 8);
+
+  printf("for:");
+  for (int i = 0; i < 8; ++i) printf(" %ld", out[i]);
+  putchar('\n');
+
+  bb_term(buffer);
+
+  bb_free(buffer);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// SBOVALUES
+void sboValues (void)
+{
+  bytebuffer_sbo_t *small = bb_sbo_alloc();
+
+  bb_sbo_init(small, 16, NULL);
+
+  printf("sbo: size: %lu inline: %d\n", bb_get_size(&small->bb),
+      bb_get_buffer(&small->bb) == small->storage);
+
+  putText(&small->bb, "ACK");
+
+  bb_put_uint32(&small->bb, 42);
+
+  bb_flip(&small->bb);
+
+  char *text = getText(&small->bb);
+
+  printf("sbo: text: %s uint32_t: %u\n", text, bb_get_uint32(&small->bb));
+
+  free(text);
+
+  bb_term(&small->bb);
+
+  // too large for the inline storage: falls back to the heap
+
+  bb_sbo_init(small, BUFFER_SIZE, NULL);
+
+  printf("sbo: size: %lu inline: %d\n", bb_get_size(&small->bb),
+      bb_get_buffer(&small->bb) == small->storage);
+
+  bb_term(&small->bb);
+
+  free(small);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// called from several threads by bb_decode_parallel
+static void decodeRecord (bytebuffer_t *view, size_t n, void *arg)
+{
+  size_t *lengths = arg;
+
+  lengths[n] = bb_get_remaining(view);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// RECORDVALUES
+void recordValues (void)
+{
+  bytebuffer_t *buffer = bb_alloc();
+
+  bb_init(buffer, BUFFER_SIZE, NULL);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    char txt [ 24 ];
+    (void) sprintf(txt, "RECORD %0*d", i + 1, i);
+    bb_put_uint32(buffer, strlen(txt));
+    bb_put_varchar(buffer, txt);
+  }
+
+  bb_flip(buffer);
+
+  bb_index_t idx = { NULL, 0, 0 };
+
+  printf("index: %ld records\n", bb_build_index(buffer, &idx));
+
+  bytebuffer_t view;
+
+  for (size_t n = 0; n < idx.count; n += 4)
+  {
+    bb_record_at(buffer, &idx, n, &view);
+
+    char *text = bb_get_varchar(&view, bb_get_remaining(&view));
+
+    printf("record: %s at: %lu\n", text, idx.offset[n]);
+
+    free(text);
+  }
+
+  size_t lengths [10] = { 0 };
+
+  bb_decode_parallel(buffer, &idx, decodeRecord, lengths, 2);
+
+  printf("decode parallel lengths:");
+  for (int i = 0; i < 10; ++i) printf(" %lu", lengths[i]);
+  putchar('\n');
+
+  bb_index_term(&idx);
+
+  bb_term(buffer);
+
+  bb_free(buffer);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// SOAVALUES
+typedef struct tick tick_t;
+
+struct tick {
+  int64_t       time;
+  double        price;
+  int32_t       quantity;
+};
+
+void soaValues (void)
+{
+  bytebuffer_t *buffer = bb_alloc();
+
+  bb_init(buffer, BUFFER_SIZE, NULL);
+
+  bb_field_t const layout [] = {
+    BB_FIELD(tick_t, time), BB_FIELD(tick_t, price),
+    BB_FIELD(tick_t, quantity), BB_FIELD_END };
+
+  tick_t ticks [4] = {
+    { 1000, 101.25, 10 }, { 1001, 101.50, -20 },
+    { 1003, 101.00, 5 }, { 1007, 100.75, 40 } };
+
+  bb_put_soa(buffer, ticks, 4, sizeof(tick_t), layout);
+
+  printf("soa: 4 ticks in %lu bytes, first quantity at: %lu\n",
+      bb_get_index(buffer), 4 * (sizeof(int64_t) + sizeof(double)));
+
+  bb_flip(buffer);
 
+  tick_t out [4];
+
+  bb_get_aos(buffer, out, 4, sizeof(tick_t), layout);
+
+  for (int i = 0; i < 4; ++i)
+    printf("aos: time: %ld price: %f quantity: %d\n",
+        out[i].time, out[i].price, out[i].quantity);
+
+  bb_term(buffer);
+
+  bb_free(buffer);
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// STREAMVALUES
+void streamValues (void)
+{
+  char path [] = "/tmp/bb_demo_XXXXXX";
+
+  int fd = mkstemp(path);
+
+  if (fd < 0) {
+    perror("mkstemp");
+    return;
+  }
+
+  (void) unlink(path);
+
+  // write 3 chunks of BUFFER_SIZE / 4 int32_t values each
+
+  bb_stream_t *out = bb_stream_open(fd, BB_STREAM_WRITE, BUFFER_SIZE, 2);
+
+  if (out == NULL) {
+    perror("bb_stream_open");
+    (void) close(fd);
+    return;
+  }
+
+  int32_t value = 0;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    bytebuffer_t *chunk = bb_stream_next(out);
+    if (chunk == NULL) break;
+    while (bb_get_remaining(chunk) >= sizeof(int32_t))
+      bb_put_int32(chunk, value++);
+  }
+
+  printf("stream write: %d values close: %d\n", value, bb_stream_close(out));
+
+  // read them back
+
+  (void) lseek(fd, 0, SEEK_SET);
+
+  bb_stream_t *in = bb_stream_open(fd, BB_STREAM_READ, BUFFER_SIZE, 2);
+
+  if (in == NULL) {
+    perror("bb_stream_open");
+    (void) close(fd);
+    return;
+  }
+
+  bytebuffer_t *chunk;
+
+  int chunks = 0;
+
+  int64_t sum = 0;
+
+  while ((chunk = bb_stream_next(in)) != NULL)
+  {
+    ++chunks;
+    while (bb_has_more(chunk)) sum += bb_get_int32(chunk);
+  }
+
+  printf("stream read: %d chunks sum: %ld close: %d\n", chunks, sum,
+      bb_stream_close(in));
+
+  (void) close(fd);
+}
@@ -67,3 +67,11 @@ void putTextAt (bytebuffer_t *, size_t, char const *);
 
 void putValues (bytebuffer_t *);
 void getValues (bytebuffer_t *);
+
+void bitValues (void);
+void halfValues (void);
+void deltaValues (void);
+void sboValues (void);
+void recordValues (void);
+void soaValues (void);
+void streamValues (void);
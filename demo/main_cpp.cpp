@@ -0,0 +1,121 @@
+/*------------------------------------------------------------------------------
+    ByteBuffer Implementation in x86_64 Assembly Language with C Interface
+
+    Copyright (C) 2025  J. McIntosh
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+------------------------------------------------------------------------------*/
+#include <cstdio>
+#include "../bytebuffer/bytebuffer.hpp"
+
+char const sep[80] =
+"- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -";
+
+struct Quote {
+  int64_t       time;
+  double        price;
+  int32_t       size;
+};
+
+void printQuote (Quote const &);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// a record is streamed field by field
+bb::Cursor & operator<< (bb::Cursor &c, Quote const &q)
+{
+  return c << q.time << q.price << q.size;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+bb::ReadCursor & operator>> (bb::ReadCursor &c, Quote &q)
+{
+  return c >> q.time >> q.price >> q.size;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+int main (int argc, char **argv)
+{
+  bb::ByteBuffer buffer(256);
+
+  // PUT: a big endian header, two quotes and a big endian array
+
+  buffer.put<uint32_t, bb::Endian::Big>(0xCAFEF00D);
+
+  buffer << Quote{ 1700000000000, 101.25, 300 } << Quote{ 1700000000250,
+      101.50, -100 };
+
+  int16_t levels [4] = { 1, -2, 300, -400 };
+
+  buffer.put<bb::Endian::Big>(levels, 4);
+
+  buffer.flip();
+
+  puts(sep);
+  printf("ByteBuffer: bound: %lu first byte: %02X\n", buffer.bound(),
+      buffer.data()[0]);
+
+  // GET: a ByteView has a cursor of its own over the same storage
+
+  bb::ByteView view(buffer);
+
+  printf("magic: %08X\n", view.get<uint32_t, bb::Endian::Big>());
+
+  Quote q;
+
+  view >> q;
+
+  printQuote(q);
+
+  view >> q;
+
+  printQuote(q);
+
+  int16_t out [4];
+
+  view.get<bb::Endian::Big>(out, 4);
+
+  printf("levels: %hd %hd %hd %hd\n", out[0], out[1], out[2], out[3]);
+
+  printf("view index: %lu buffer index: %lu\n", view.index(),
+      bb_get_index(buffer.native()));
+
+  // the C functions share the same bytebuffer_t
+
+  printf("bb_get_uint32 (little endian): %08X\n",
+      bb_get_uint32(buffer.native()));
+
+  // a ConstByteView reads storage that must not be written
+
+  static unsigned char const packet [] = { 0x12, 0x34, 0x78, 0x56 };
+
+  bb::ConstByteView reader(packet, sizeof(packet));
+
+  uint16_t be = reader.get<uint16_t, bb::Endian::Big>();
+
+  uint16_t le;
+
+  reader >> le;
+
+  printf("packet: big endian: %04X little endian: %04X\n", be, le);
+  puts(sep);
+
+  return 0;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+void printQuote (Quote const &q)
+{
+  printf("quote: time: %ld price: %f size: %d\n", q.time, q.price, q.size);
+}